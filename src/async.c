@@ -0,0 +1,354 @@
+#include <string.h>
+
+#include "async.h"
+
+static void * async_alloc (size_t n, size_t size)
+{
+    void *r = malloc ((n > 0 ? n : 1) * size);
+    if (!r)
+        Rf_error ("Unable to allocate background calculation"); // # nocov
+    return r;
+}
+
+static double * async_copy (const double *x, size_t n)
+{
+    if (x == NULL)
+        return NULL;
+    double *r = (double *) async_alloc (n, sizeof (double));
+    memcpy (r, x, n * sizeof (double));
+    return r;
+}
+
+//' Private copies of point tables from `point_tables_init()`, which are
+//' R_alloc-ed, and so only valid for the duration of the creating call
+//' @noRd
+static void async_tables_copy (const point_tables *p, point_tables *out)
+{
+    out->n = p->n;
+    out->x = async_copy (p->x, p->n);
+    out->y = async_copy (p->y, p->n);
+    out->siny = async_copy (p->siny, p->n);
+    out->cosy = async_copy (p->cosy, p->n);
+    out->u = async_copy (p->u, 3 * p->n);
+    out->pts = NULL;
+    out->na = NULL;
+    if (p->pts)
+    {
+        struct geod_point *pts = (struct geod_point *) async_alloc (p->n,
+                sizeof (struct geod_point));
+        memcpy (pts, p->pts, p->n * sizeof (struct geod_point));
+        out->pts = pts;
+    }
+    if (p->na)
+    {
+        unsigned char *na = (unsigned char *) async_alloc (p->n, 1);
+        memcpy (na, p->na, p->n);
+        out->na = na;
+    }
+}
+
+static void async_tables_free (point_tables *p)
+{
+    free ((void *) p->x);
+    free ((void *) p->y);
+    free ((void *) p->siny);
+    free ((void *) p->cosy);
+    free ((void *) p->pts);
+    free ((void *) p->u);
+    free ((void *) p->na);
+    memset (p, 0, sizeof (point_tables));
+}
+
+//' Calculate all rows of a job, on the background thread
+//'
+//' Rows are passed to the same row kernels as `kernel_tri_dists()` and
+//' `kernel_xy_dists()`, in segments of TILE_NY pairs, so that all distances
+//' are identical to those of `geodist()`. No R API functions are called. The
+//' cancel flag is checked before each row, and tables are freed as soon as
+//' all rows are finished.
+//' @noRd
+static void async_run (async_job *j)
+{
+    size_t nx = j->p1.n, ny = j->p2.n;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (j->nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t i = 0; i < nx; i++)
+    {
+        if (atomic_load (&j->cancel))
+            continue;
+
+        double *buf = j->scratch + omp_get_thread_num () * TILE_NY;
+        size_t jstart = 0;
+        if (j->symmetric)
+        {
+            j->out [i * nx + i] = 0.0;
+            jstart = i + 1;
+        }
+
+        for (size_t j0 = jstart; j0 < ny; j0 += TILE_NY)
+        {
+            size_t n = (ny - j0 < TILE_NY) ? ny - j0 : TILE_NY;
+            kernel_row (j->measure, &j->p1, i, &j->p2, j0, n, j->cosy,
+                    j->simd, buf);
+            for (size_t k = 0; k < n; k++)
+                j->out [i + (j0 + k) * nx] = buf [k];
+            if (j->symmetric)
+                for (size_t k = 0; k < n; k++)
+                    j->out [(j0 + k) + i * nx] = buf [k];
+        }
+
+        atomic_fetch_add (&j->rows, 1);
+    }
+
+    if (!j->symmetric)
+        async_tables_free (&j->p2);
+    async_tables_free (&j->p1);
+
+    atomic_store (&j->state, (atomic_load (&j->rows) == nx) ?
+            ASYNC_DONE : ASYNC_CANCELLED);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI async_main (LPVOID arg)
+{
+    async_run ((async_job *) arg);
+    return 0;
+}
+#else
+static void * async_main (void *arg)
+{
+    async_run ((async_job *) arg);
+    return NULL;
+}
+#endif
+
+static void async_join (async_job *j)
+{
+    if (!j->started)
+        return;
+#ifdef _WIN32
+    WaitForSingleObject (j->thread, INFINITE);
+    CloseHandle (j->thread);
+#else
+    pthread_join (j->thread, NULL);
+#endif
+    j->started = 0;
+}
+
+//' Cancel and wait for any running calculation before freeing the job, so
+//' that the worker never writes to a result which has been collected
+//' @noRd
+static void async_finalizer (SEXP job_)
+{
+    async_job *j = (async_job *) R_ExternalPtrAddr (job_);
+    if (j)
+    {
+        atomic_store (&j->cancel, 1);
+        async_join (j);
+        if (!j->symmetric)
+            async_tables_free (&j->p2);
+        async_tables_free (&j->p1);
+        free (j->scratch);
+        free (j);
+        R_ClearExternalPtr (job_);
+    }
+}
+
+//' Start one full distance matrix on a background thread
+//'
+//' All R objects are created, and all R API functions called, here on the
+//' main thread. The result matrix is allocated in full before the worker
+//' starts, and only returned by `R_async_result()` once all rows are done.
+//'
+//' @param y_ Either NULL for distances between all pairs of x_, or a second
+//' set of points.
+//' @return External pointer to an `async_job`, cancelled and freed on garbage
+//' collection.
+//' @noRd
+static SEXP async_start (measure_t measure, SEXP x_, SEXP y_, SEXP threads_)
+{
+    int symmetric = Rf_isNull (y_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = symmetric ? nx : (size_t) (floor (length (y_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (symmetric ? x_ : Rf_coerceVector (y_, REALSXP));
+    double *rx = REAL (x_), *ry = REAL (y_);
+
+    SEXP out = PROTECT (Rf_allocMatrix (REALSXP, (int) nx, (int) ny));
+
+    async_job *j = (async_job *) calloc (1, sizeof (async_job));
+    if (!j)
+        Rf_error ("Unable to allocate background calculation"); // # nocov
+
+    SEXP job_ = PROTECT (R_MakeExternalPtr (j, Rf_install ("geodist_async"),
+                out));
+    R_RegisterCFinalizerEx (job_, async_finalizer, TRUE);
+
+    j->measure = measure;
+    j->symmetric = symmetric;
+    j->nthreads = nthreads;
+    j->simd = batch_enabled ();
+    j->out = REAL (out);
+    atomic_init (&j->rows, 0);
+    atomic_init (&j->cancel, 0);
+    atomic_init (&j->state, ASYNC_RUNNING);
+
+    point_tables p;
+    point_tables_init (measure, rx, rx + nx, nx, &p);
+    async_tables_copy (&p, &j->p1);
+    if (symmetric)
+        j->p2 = j->p1;
+    else
+    {
+        point_tables_init (measure, ry, ry + ny, ny, &p);
+        async_tables_copy (&p, &j->p2);
+    }
+
+    if (measure == MEASURE_CHEAP)
+        j->cosy = symmetric ? cheap_cosy (rx + nx, nx, NULL, 0) :
+            cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    j->scratch = (double *) async_alloc ((size_t) nthreads * TILE_NY,
+            sizeof (double));
+
+#ifdef _WIN32
+    j->thread = CreateThread (NULL, 0, async_main, j, 0, NULL);
+    j->started = (j->thread != NULL);
+#else
+    j->started = (pthread_create (&j->thread, NULL, async_main, j) == 0);
+#endif
+    if (!j->started)
+        Rf_error ("Unable to start background calculation"); // # nocov
+
+    UNPROTECT (4);
+
+    return job_;
+}
+
+static async_job * async_get (SEXP job_)
+{
+    if (TYPEOF (job_) != EXTPTRSXP ||
+            R_ExternalPtrTag (job_) != Rf_install ("geodist_async"))
+        Rf_error ("job must be a 'geodist_async' object");
+    async_job *j = (async_job *) R_ExternalPtrAddr (job_);
+    if (!j)
+        Rf_error ("job is no longer valid, and must be re-started");
+    return j;
+}
+
+//' R_haversine_async
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ NULL, or additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)]
+//' @noRd
+SEXP R_haversine_async (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return async_start (MEASURE_HAVERSINE, x_, y_, threads_);
+}
+
+//' R_vincenty_async
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ NULL, or additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)]
+//' @noRd
+SEXP R_vincenty_async (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return async_start (MEASURE_VINCENTY, x_, y_, threads_);
+}
+
+//' R_cheap_async
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ NULL, or additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)]
+//' @noRd
+SEXP R_cheap_async (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return async_start (MEASURE_CHEAP, x_, y_, threads_);
+}
+
+//' R_geodesic_async
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ NULL, or additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)]
+//' @noRd
+SEXP R_geodesic_async (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return async_start (MEASURE_GEODESIC, x_, y_, threads_);
+}
+
+//' R_ruler_async
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ NULL, or additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)]
+//' @noRd
+SEXP R_ruler_async (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return async_start (MEASURE_RULER, x_, y_, threads_);
+}
+
+//' R_async_status
+//' @param job_ External pointer to an `async_job`
+//' @return Vector of the state of the job (0 = running, 1 = done, 2 =
+//' cancelled), and the numbers of rows completed and in total.
+//' @noRd
+SEXP R_async_status (SEXP job_)
+{
+    async_job *j = async_get (job_);
+
+    SEXP out = PROTECT (allocVector (REALSXP, 3));
+    SEXP nms = PROTECT (allocVector (STRSXP, 3));
+    const char *names [3] = {"state", "rows", "total"};
+    for (int i = 0; i < 3; i++)
+        SET_STRING_ELT (nms, i, mkChar (names [i]));
+
+    // State is read first, so that rows are never less than total for jobs
+    // which are reported as done:
+    REAL (out) [0] = (double) atomic_load (&j->state);
+    REAL (out) [1] = (double) atomic_load (&j->rows);
+    REAL (out) [2] = (double) Rf_nrows (R_ExternalPtrProtected (job_));
+    setAttrib (out, R_NamesSymbol, nms);
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_async_cancel
+//'
+//' Rows already started are finished, and the job is then reported as
+//' cancelled, unless all rows were already done.
+//' @param job_ External pointer to an `async_job`
+//' @noRd
+SEXP R_async_cancel (SEXP job_)
+{
+    async_job *j = async_get (job_);
+    atomic_store (&j->cancel, 1);
+    return R_NilValue;
+}
+
+//' R_async_result
+//' @param job_ External pointer to an `async_job`
+//' @return The full matrix of distances once all rows have been calculated,
+//' otherwise NULL.
+//' @noRd
+SEXP R_async_result (SEXP job_)
+{
+    async_job *j = async_get (job_);
+    int state = atomic_load (&j->state);
+
+    if (state == ASYNC_RUNNING)
+        return R_NilValue;
+    if (state == ASYNC_CANCELLED)
+        Rf_error ("Calculation was cancelled");
+
+    async_join (j);
+    SEXP out = R_ExternalPtrProtected (job_);
+    // The result is shared with the job, so must be copied on modification:
+    MARK_NOT_MUTABLE (out);
+
+    return out;
+}
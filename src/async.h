@@ -0,0 +1,64 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stdatomic.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef enum
+{
+    ASYNC_RUNNING = 0,
+    ASYNC_DONE,
+    ASYNC_CANCELLED
+} async_state;
+
+// One full distance matrix calculated on a background thread, with private
+// copies of all point tables so that the worker never touches R objects
+// other than the pre-allocated result, which is held in the protected field
+// of the external pointer.
+typedef struct
+{
+    measure_t measure;
+    point_tables p1, p2;
+    int symmetric; // 1 for distances between all pairs of p1 only
+    double cosy; // constant cosine multiplier for cheap distances
+    int simd;
+    int nthreads;
+    double *out; // (p1.n * p2.n) matrix with x varying fastest
+    double *scratch; // TILE_NY values for each thread
+
+    atomic_size_t rows; // rows of p1 completed
+    atomic_int cancel;
+    atomic_int state;
+
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    int started;
+} async_job;
+
+SEXP R_haversine_async (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_async (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_async (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_async (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_async (SEXP x_, SEXP y_, SEXP threads_);
+
+SEXP R_async_status (SEXP job_);
+SEXP R_async_cancel (SEXP job_);
+SEXP R_async_result (SEXP job_);
+
+#endif /* ASYNC_H */
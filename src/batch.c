@@ -0,0 +1,340 @@
+// Contraction of products and sums into fused multiply-adds would otherwise
+// give non-zero vincenty distances between identical points.
+#if defined (__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined (__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#include <math.h>
+#include <stdint.h>
+
+#include "batch.h"
+
+// Vectorisable batch versions of the haversine, vincenty, and cheap kernels
+// of common.c. Calls to libm sqrt, sin, cos, asin, and atan2 can not be
+// vectorised, and are replaced here by the fdlibm polynomial and rational
+// approximations,
+// inlined into loops without branches so that each loop processes 2, 4, or
+// 8 pairs of points at once with SSE2, AVX2, or AVX-512 respectively.
+//
+// Maximal errors of the approximations relative to exact values, measured
+// over 2 * 10^7 random arguments, are:
+//     sqrt:            1 ULP
+//     sin, cos:        1.6 ULP for |x| < 4 pi
+//     asin (x):        2.5 ULP for x in [0, 1]
+//     atan2 (y, x):    2.7 ULP for y >= 0
+// Arguments of sin and cos are differences in longitude or latitude, and so
+// never exceed 4 pi. Measured over 10^6 random pairs, vincenty distances
+// differ from those of the scalar kernels by relative amounts of up to 1e-14.
+// Haversine distances differ by up to 3e-14 for separations below 99.9 % of
+// half the circumference, but by up to 1.3e-8, or around 0.3 m, for
+// (near-)antipodal pairs. There `asin (sqrt (d))` is evaluated with d close
+// to 1, where both kernels lose half of the precision of d, so neither is
+// more accurate than the other. The batch kernels are only used with
+// 'options (geodist.simd = TRUE)'.
+
+// pi / 2 in two parts for Cody-Waite argument reduction; HI has 33
+// significant bits, so that k * PIO2_HI is exact for |k| < 2^20.
+static const double PIO2_HI = 1.57079632673412561417e+00;
+static const double PIO2_LO = 6.07710050650619224932e-11;
+// Nearest double to pi / 2, and remainder
+static const double PIO2 = 1.57079632679489655800e+00;
+static const double PIO2_R = 6.12323399573676603587e-17;
+static const double PIO4 = 7.85398163397448278999e-01;
+static const double PIO4_R = 3.06161699786838301793e-17;
+static const double TAN_PIO8 = 0.41421356237309503;
+
+// fdlibm __kernel_sin and __kernel_cos, for |x| < pi / 4
+static const double S1 = -1.66666666666666324348e-01;
+static const double S2 = 8.33333333332248946124e-03;
+static const double S3 = -1.98412698298579493134e-04;
+static const double S4 = 2.75573137070700676789e-06;
+static const double S5 = -2.50507602534068634195e-08;
+static const double S6 = 1.58969099521155010221e-10;
+
+static const double C1 = 4.16666666666666019037e-02;
+static const double C2 = -1.38888888888741095749e-03;
+static const double C3 = 2.48015872894767294178e-05;
+static const double C4 = -2.75573143513906633035e-07;
+static const double C5 = 2.08757232129817482790e-09;
+static const double C6 = -1.13596475577881948265e-11;
+
+// fdlibm e_asin.c rational approximation, for |x| < 0.5
+static const double PS0 = 1.66666666666666657415e-01;
+static const double PS1 = -3.25565818622400915405e-01;
+static const double PS2 = 2.01212532134862925881e-01;
+static const double PS3 = -4.00555345006794114027e-02;
+static const double PS4 = 7.91534994289814532176e-04;
+static const double PS5 = 3.47933107596021167570e-05;
+static const double QS1 = -2.40339491173441421878e+00;
+static const double QS2 = 2.02094576023350569471e+00;
+static const double QS3 = -6.88283971605453293030e-01;
+static const double QS4 = 7.70381505559019352791e-02;
+
+// fdlibm s_atan.c polynomial, for |x| < 7 / 16
+static const double AT0 = 3.33333333333329318027e-01;
+static const double AT1 = -1.99999999998764832476e-01;
+static const double AT2 = 1.42857142725034663711e-01;
+static const double AT3 = -1.11111104054623557880e-01;
+static const double AT4 = 9.09088713343650656196e-02;
+static const double AT5 = -7.69187620504482999495e-02;
+static const double AT6 = 6.66107313738753120669e-02;
+static const double AT7 = -5.83357013379057348645e-02;
+static const double AT8 = 4.97687799461593236017e-02;
+static const double AT9 = -3.65315727442169155270e-02;
+static const double AT10 = 1.62858201153657823623e-02;
+
+// Round to nearest integer, for |x| < 2^51, without a libm call
+static inline double round_int (double x)
+{
+    const double magic = 6755399441055744.0; // 1.5 * 2^52
+    return (x + magic) - magic;
+}
+
+// Branch-free selection of a if c is 1, or b if c is 0. Ternary operators
+// on floating point values prevent vectorisation with SSE2 and AVX2, because
+// compilers can not if-convert branches with arithmetic which might raise
+// floating point exceptions.
+static inline double blend (int c, double a, double b)
+{
+    union { double d; uint64_t u; } ua = { a }, ub = { b };
+    uint64_t m = (uint64_t) 0 - (uint64_t) c;
+    ua.u = (ua.u & m) | (ub.u & ~m);
+    return ua.d;
+}
+
+// sqrt for x >= 0. libm sqrt, and even the square root instruction, can not
+// be vectorised unless compiled with -fno-math-errno, so this uses Newton
+// iterations for 1 / sqrt (x) from an initial approximation of integer
+// arithmetic on the IEEE representation, with a final correction for sqrt
+// itself. Maximal error is 1 ULP.
+static inline double poly_sqrt (double x)
+{
+    union { double d; uint64_t u; } v = { x };
+    v.u = 0x5fe6eb50c7b537a9ULL - (v.u >> 1);
+    double y = v.d;
+
+    double hx = 0.5 * x;
+    y = y * (1.5 - hx * y * y);
+    y = y * (1.5 - hx * y * y);
+    y = y * (1.5 - hx * y * y);
+    y = y * (1.5 - hx * y * y);
+
+    double s = x * y;
+    return s + 0.5 * y * (x - s * s);
+}
+
+static inline void poly_sincos (double x, double *s, double *c)
+{
+    double k = round_int (x * M_2_PI);
+    // Quadrants are taken from k only where the conversion to int is defined,
+    // and otherwise from 0, while NaN and infinite x still flow through r.
+    double kq = blend (fabs (k) < 1073741824.0, k, 0.0);
+    int q = (int) kq & 3;
+    double r = (x - k * PIO2_HI) - k * PIO2_LO;
+    double z = r * r;
+
+    double sr = r + r * z *
+        (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+    double cr = 1.0 - 0.5 * z + z * z *
+        (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+
+    double sq = blend (q & 1, cr, sr);
+    double cq = blend (q & 1, sr, cr);
+    *s = blend ((q >> 1) & 1, -sq, sq);
+    *c = blend (((q + 1) >> 1) & 1, -cq, cq);
+}
+
+static inline double poly_sin (double x)
+{
+    double s, c;
+    poly_sincos (x, &s, &c);
+    return s;
+}
+
+static inline double asin_r (double z)
+{
+    double p = z * (PS0 + z * (PS1 + z * (PS2 + z * (PS3 + z * (PS4 + z * PS5)))));
+    double q = 1.0 + z * (QS1 + z * (QS2 + z * (QS3 + z * QS4)));
+    return p / q;
+}
+
+// asin for x in [0, 1]. Both ranges of the fdlibm approximation share one
+// rational function evaluation, and all divisions are unconditional so that
+// loops can be vectorised without masking.
+static inline double poly_asin (double x)
+{
+    int lo = x < 0.5;
+    double z = blend (lo, x * x, 0.5 * (1.0 - x));
+    double s = poly_sqrt (z);
+    double r = asin_r (z);
+
+    double a_lo = x + x * r;
+    double a_hi = PIO2 - (2.0 * (s + s * r) - PIO2_R);
+
+    return blend (lo, a_lo, a_hi);
+}
+
+static inline double poly_atan (double x)
+{
+    double z = x * x;
+    double w = z * z;
+    double s1 = z * (AT0 + w * (AT2 + w * (AT4 + w * (AT6 + w * (AT8 + w * AT10)))));
+    double s2 = w * (AT1 + w * (AT3 + w * (AT5 + w * (AT7 + w * AT9))));
+    return x - x * (s1 + s2);
+}
+
+// atan2 for y >= 0
+static inline double poly_atan2 (double y, double x)
+{
+    double ax = fabs (x);
+    int steep = y > ax;
+    double mx = blend (steep, y, ax);
+    double mn = blend (steep, ax, y);
+    double z = mn / blend (mx > 0.0, mx, 1.0);
+
+    int big = z > TAN_PIO8;
+    double u = blend (big, z - 1.0, z) / blend (big, z + 1.0, 1.0);
+    double a = poly_atan (u);
+
+    a = blend (big, PIO4 + (a + PIO4_R), a);
+    a = blend (steep, PIO2 - (a - PIO2_R), a);
+    a = blend (x < 0.0, 2.0 * PIO2 - (a - 2.0 * PIO2_R), a);
+
+    return a;
+}
+
+//' Whether batch kernels have been enabled with 'options (geodist.simd)'
+//'
+//' Must be called from the master thread only.
+//' @noRd
+int batch_enabled (void)
+{
+    SEXP opt = Rf_GetOption1 (Rf_install ("geodist.simd"));
+    return opt != R_NilValue && Rf_asLogical (opt) == 1;
+}
+
+//' R_batch_vectorised
+//'
+//' @return TRUE if batch kernels were compiled with both runtime dispatch of
+//' instruction sets and '#pragma omp simd', and so process several pairs of
+//' points at once; otherwise FALSE, in which case they are scalar loops of
+//' polynomial approximations, and no faster than the default kernels.
+//' @noRd
+SEXP R_batch_vectorised (void)
+{
+#ifdef _OPENMP
+    int openmp = 1;
+#else
+    int openmp = 0;
+#endif
+    return Rf_ScalarLogical (BATCH_MULTIVERSIONED && openmp);
+}
+
+BATCH_DISPATCH
+void batch_haversine_row (double x1, double y1, double cosy1,
+        const double *x2, const double *y2, const double *cosy2,
+        size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double sxd = poly_sin ((x2 [j] - x1) * M_PI / 360.0);
+        double syd = poly_sin ((y2 [j] - y1) * M_PI / 360.0);
+        double d = syd * syd + cosy1 * cosy2 [j] * sxd * sxd;
+        out [j] = 2.0 * earth * poly_asin (poly_sqrt (d));
+    }
+}
+
+BATCH_DISPATCH
+void batch_haversine_pairs (const double *x1, const double *y1,
+        const double *cosy1, const double *x2, const double *y2,
+        const double *cosy2, size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double sxd = poly_sin ((x2 [j] - x1 [j]) * M_PI / 360.0);
+        double syd = poly_sin ((y2 [j] - y1 [j]) * M_PI / 360.0);
+        double d = syd * syd + cosy1 [j] * cosy2 [j] * sxd * sxd;
+        out [j] = 2.0 * earth * poly_asin (poly_sqrt (d));
+    }
+}
+
+BATCH_DISPATCH
+void batch_vincenty_row (double x1, double siny1, double cosy1,
+        const double *x2, const double *siny2, const double *cosy2,
+        size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double sxd, cxd;
+        poly_sincos ((x2 [j] - x1) * M_PI / 180.0, &sxd, &cxd);
+        double n1 = cosy2 [j] * sxd;
+        double n2 = cosy1 * siny2 [j] - siny1 * cosy2 [j] * cxd;
+        double numerator = n1 * n1 + n2 * n2;
+        double denominator = siny1 * siny2 [j] + cosy1 * cosy2 [j] * cxd;
+        out [j] = earth * poly_atan2 (poly_sqrt (numerator), denominator);
+    }
+}
+
+BATCH_DISPATCH
+void batch_vincenty_pairs (const double *x1, const double *siny1,
+        const double *cosy1, const double *x2, const double *siny2,
+        const double *cosy2, size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double sxd, cxd;
+        poly_sincos ((x2 [j] - x1 [j]) * M_PI / 180.0, &sxd, &cxd);
+        double n1 = cosy2 [j] * sxd;
+        double n2 = cosy1 [j] * siny2 [j] - siny1 [j] * cosy2 [j] * cxd;
+        double numerator = n1 * n1 + n2 * n2;
+        double denominator = siny1 [j] * siny2 [j] +
+            cosy1 [j] * cosy2 [j] * cxd;
+        out [j] = earth * poly_atan2 (poly_sqrt (numerator), denominator);
+    }
+}
+
+BATCH_DISPATCH
+void batch_cheap_row (double x1, double y1,
+        const double *x2, const double *y2, double cosy,
+        size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double dy = meridian * (y1 - y2 [j]) / 180.0;
+        double dx = equator * (x1 - x2 [j]) * cosy / 360.0;
+        out [j] = poly_sqrt (dx * dx + dy * dy);
+    }
+}
+
+BATCH_DISPATCH
+void batch_cheap_pairs (const double *x1, const double *y1,
+        const double *x2, const double *y2, double cosy,
+        size_t n, double *out)
+{
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t j = 0; j < n; j++)
+    {
+        double dy = meridian * (y1 [j] - y2 [j]) / 180.0;
+        double dx = equator * (x1 [j] - x2 [j]) * cosy / 360.0;
+        out [j] = poly_sqrt (dx * dx + dy * dy);
+    }
+}
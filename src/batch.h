@@ -0,0 +1,50 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stddef.h>
+
+#include "WSG84-defs.h"
+
+// Runtime CPU dispatch of batch kernels through GCC function multi-versioning.
+// Each kernel is compiled for AVX-512, AVX2, and baseline instruction sets,
+// with the appropriate version selected on first call. Other compilers and
+// platforms use the baseline version only, which is still vectorised where
+// possible through '#pragma omp simd'.
+#if defined (__GNUC__) && !defined (__clang__) && defined (__x86_64__) && \
+    defined (__linux__) && (__GNUC__ >= 6)
+#define BATCH_DISPATCH __attribute__ ((target_clones ("avx512f", "avx2", "default")))
+#define BATCH_MULTIVERSIONED 1
+#else
+#define BATCH_DISPATCH
+#define BATCH_MULTIVERSIONED 0
+#endif
+
+int batch_enabled (void);
+SEXP R_batch_vectorised (void);
+
+// One point against n points, writing n distances to out
+void batch_haversine_row (double x1, double y1, double cosy1,
+        const double *x2, const double *y2, const double *cosy2,
+        size_t n, double *out);
+void batch_vincenty_row (double x1, double siny1, double cosy1,
+        const double *x2, const double *siny2, const double *cosy2,
+        size_t n, double *out);
+void batch_cheap_row (double x1, double y1,
+        const double *x2, const double *y2, double cosy,
+        size_t n, double *out);
+
+// n pairs of points, writing n distances to out
+void batch_haversine_pairs (const double *x1, const double *y1,
+        const double *cosy1, const double *x2, const double *y2,
+        const double *cosy2, size_t n, double *out);
+void batch_vincenty_pairs (const double *x1, const double *siny1,
+        const double *cosy1, const double *x2, const double *siny2,
+        const double *cosy2, size_t n, double *out);
+void batch_cheap_pairs (const double *x1, const double *y1,
+        const double *x2, const double *y2, double cosy,
+        size_t n, double *out);
+
+#endif /* BATCH_H */
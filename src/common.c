@@ -1,5 +1,8 @@
 #include <math.h>
 #include <stdio.h> 
+#include <string.h>
+
+#include <R.h>
 
 #include "common.h"
 #include "WSG84-defs.h"
@@ -8,6 +11,32 @@
 
 // Core calculations for a single distance measure
 
+// WGS-84 ellipsoid for Karney geodesics. geod_init() fills the A3/C3/C4
+// coefficient tables, which only depend on the ellipsoid, so it is run once
+// when the package is loaded (from R_init_geodist), and the resultant struct
+// is read-only thereafter and so safe to share between all calls.
+static struct geod_geodesic g_wgs84;
+static int g_wgs84_initialised = 0;
+
+//' Initialise the shared WGS-84 geodesic context
+//' @noRd
+void geodesic_init (void)
+{
+    if (!g_wgs84_initialised)
+    {
+        geod_init(&g_wgs84, earth, flattening);
+        g_wgs84_initialised = 1;
+    }
+}
+
+//' Shared WGS-84 geodesic context
+//' @noRd
+const struct geod_geodesic * geodesic_wgs84 (void)
+{
+    geodesic_init ();
+    return &g_wgs84;
+}
+
 //' Haversine for variable x and y
 //'
 //' @return single distance
@@ -54,6 +83,83 @@ double one_cheap (double x1, double y1, double x2, double y2, double cosy)
     return d;
 }
 
+// Multipliers of the WGS-84 cheap ruler at every 1 / RULER_BANDS_PER_DEGREE
+// degrees of latitude from -90 to 90, with slopes to the following value.
+// Linear interpolation between these values gives multipliers within around
+// 2e-6 of those at the exact latitude.
+#define RULER_BANDS_PER_DEGREE 4
+#define RULER_NBANDS (180 * RULER_BANDS_PER_DEGREE)
+
+typedef struct
+{
+    double kx, ky, dkx, dky;
+} ruler_band;
+
+static ruler_band ruler_bands [RULER_NBANDS + 1];
+static int ruler_initialised = 0;
+
+//' Fill the table of cheap ruler multipliers, once only
+//'
+//' Multipliers are those of mapbox's `CheapRuler`, in metres per degree of
+//' longitude (kx) and latitude (ky), from the radii of curvature of the WGS-84
+//' ellipsoid.
+//' @noRd
+void ruler_init (void)
+{
+    if (ruler_initialised)
+        return;
+
+    const double e2 = flattening * (2.0 - flattening);
+    const double m = earth * M_PI / 180.0;
+
+    for (size_t k = 0; k <= RULER_NBANDS; k++)
+    {
+        double lat = -90.0 + (double) k / RULER_BANDS_PER_DEGREE;
+        double coslat = cos (lat * M_PI / 180.0);
+        double w2 = 1.0 / (1.0 - e2 * (1.0 - coslat * coslat));
+        double w = sqrt (w2);
+        ruler_bands [k].kx = m * w * coslat;
+        ruler_bands [k].ky = m * w * w2 * (1.0 - e2);
+    }
+    for (size_t k = 0; k < RULER_NBANDS; k++)
+    {
+        ruler_bands [k].dkx = ruler_bands [k + 1].kx - ruler_bands [k].kx;
+        ruler_bands [k].dky = ruler_bands [k + 1].ky - ruler_bands [k].ky;
+    }
+    ruler_bands [RULER_NBANDS].dkx = ruler_bands [RULER_NBANDS].dky = 0.0;
+
+    ruler_initialised = 1;
+}
+
+//' Cheap ruler with multipliers at the mid-latitude of each pair
+//'
+//' Unlike `one_cheap()`, multipliers are looked up for each pair of points
+//' from the table of `ruler_init()`, with no pass over all points, and
+//' differences in longitude are wrapped to [-180, 180].
+//' @return single distance, NaN if any coordinates are missing
+//' @noRd
+double one_ruler (double x1, double y1, double x2, double y2)
+{
+    double t = (y1 + y2 + 180.0) * (0.5 * RULER_BANDS_PER_DEGREE);
+    if (!(t > 0.0)) // also NaN, for which distances remain NaN
+        t = 0.0;
+    else if (t > RULER_NBANDS)
+        t = RULER_NBANDS;
+    size_t k = (size_t) t;
+    double f = t - (double) k;
+    const ruler_band *b = ruler_bands + k;
+
+    double dlon = x2 - x1;
+    if (dlon > 180.0)
+        dlon -= 360.0;
+    else if (dlon < -180.0)
+        dlon += 360.0;
+
+    double dx = dlon * (b->kx + f * b->dkx);
+    double dy = (y2 - y1) * (b->ky + f * b->dky);
+    return sqrt (dx * dx + dy * dy);
+}
+
 //' Karney (2013) geodesic
 //' https://geographiclib.sourceforge.io/geod.html
 //' https://link.springer.com/content/pdf/10.1007/s00190-012-0578-z.pdf
@@ -61,9 +167,275 @@ double one_geodesic (double x1, double y1, double x2, double y2)
 {
     //double lat1, lon1, azi1, lat2, lon2, azi2, s12;
     double azi1, azi2, s12;
-    struct geod_geodesic g;
 
-    geod_init(&g, earth, flattening);
-    geod_inverse(&g, y1, x1, y2, x2, &s12, &azi1, &azi2);
+    geod_inverse(&g_wgs84, y1, x1, y2, x2, &s12, &azi1, &azi2);
+    return s12;
+}
+
+//' Karney (2013) geodesic, along with azimuths at both points in degrees
+//' clockwise from north, from the same evaluation as `one_geodesic()`
+//' @noRd
+double one_geodesic_azi (double x1, double y1, double x2, double y2,
+        double *azi1, double *azi2)
+{
+    double s12;
+
+    geod_inverse(&g_wgs84, y1, x1, y2, x2, &s12, azi1, azi2);
+    return s12;
+}
+
+//' Karney (2013) geodesic between points initialised by `geodesic_points()`
+//'
+//' Identical to `one_geodesic()`, but without recalculating the
+//' latitude-dependent terms of either point.
+//' @noRd
+double one_geodesic_pts (const struct geod_point *p1,
+        const struct geod_point *p2)
+{
+    double s12;
+
+    geod_inverse_many(&g_wgs84, p1, 1, p2, &s12);
     return s12;
 }
+
+//' Per-point terms of one set of points needed by a distance measure
+//'
+//' Haversine distances need only cosines of latitudes, along with unit
+//' vectors with 'options (geodist.chord = TRUE)', Vincenty distances sines
+//' and cosines, geodesics the terms of `geodesic_points()`, and cheap and
+//' ruler distances none at all. All are allocated with R_alloc. Must be called
+//' from the master thread only.
+//' @noRd
+void point_tables_init (measure_t measure, const double *x, const double *y,
+        size_t n, point_tables *p)
+{
+    point_tables_init_na (measure, x, y, n, coords_validate (x, y, n), p);
+}
+
+//' As for `point_tables_init()`, for coordinates already validated by
+//' `coords_validate()`, which returned the mask `na`
+//' @noRd
+void point_tables_init_na (measure_t measure, const double *x, const double *y,
+        size_t n, const unsigned char *na, point_tables *p)
+{
+    double *siny = NULL, *cosy = NULL;
+
+    if (measure == MEASURE_HAVERSINE)
+        trig_tables (y, n, NULL, &cosy);
+    else if (measure == MEASURE_VINCENTY)
+        trig_tables (y, n, &siny, &cosy);
+    else if (measure == MEASURE_RULER)
+        ruler_init ();
+
+    p->x = x;
+    p->y = y;
+    p->siny = siny;
+    p->cosy = cosy;
+    p->pts = (measure == MEASURE_GEODESIC) ? geodesic_points (x, y, n) : NULL;
+    p->n = n;
+    p->u = (measure == MEASURE_HAVERSINE && chord_enabled ()) ?
+        unit_vectors (x, y, n) : NULL;
+    p->na = na;
+}
+
+//' Per-point terms for traversals which use each point only once or twice
+//'
+//' As for `point_tables_init()`, except that geodesics of pairs are calculated
+//' directly from coordinates, and so need no terms of `geodesic_points()`, and
+//' that haversine distances of pairs never use unit vectors, the cost of which
+//' would not be recovered.
+//' @noRd
+void pair_tables_init (measure_t measure, const double *x, const double *y,
+        size_t n, point_tables *p)
+{
+    if (measure != MEASURE_GEODESIC && measure != MEASURE_HAVERSINE)
+    {
+        point_tables_init (measure, x, y, n, p);
+        return;
+    }
+
+    double *cosy = NULL;
+    if (measure == MEASURE_HAVERSINE)
+        trig_tables (y, n, NULL, &cosy);
+
+    p->x = x;
+    p->y = y;
+    p->siny = NULL;
+    p->cosy = cosy;
+    p->pts = NULL;
+    p->n = n;
+    p->u = NULL;
+    p->na = coords_validate (x, y, n);
+}
+
+//' Point tables of p without the first k points
+//' @noRd
+void point_tables_shift (const point_tables *p, size_t k, point_tables *out)
+{
+    if (k > p->n)
+        k = p->n;
+    out->x = p->x + k;
+    out->y = p->y + k;
+    out->siny = p->siny ? p->siny + k : NULL;
+    out->cosy = p->cosy ? p->cosy + k : NULL;
+    out->pts = p->pts ? p->pts + k : NULL;
+    out->n = p->n - k;
+    out->u = p->u ? p->u + 3 * k : NULL;
+    out->na = p->na ? p->na + k : NULL;
+}
+
+//' Validate the ranges of coordinates, and mark any missing points
+//'
+//' A single pass over both coordinates, which errors for any finite latitude
+//' outside [-90, 90] or longitude outside [-180, 360], so that such errors
+//' are raised before any distances are calculated. Points with any NA, NaN,
+//' or infinite coordinate have NA distances to all other points. Must be
+//' called from the master thread only.
+//'
+//' @return R_alloc-ed array of 1 for each missing point and 0 otherwise, or
+//' NULL if all points are finite, so that traversals of complete coordinates
+//' only ever test a single pointer.
+//' @noRd
+unsigned char * coords_validate (const double *x, const double *y, size_t n)
+{
+    unsigned char *na = NULL;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!isfinite (x [i]) || !isfinite (y [i]))
+        {
+            if (na == NULL)
+            {
+                na = (unsigned char *) stats_alloc (n, sizeof (unsigned char));
+                memset (na, 0, n);
+            }
+            na [i] = 1;
+            continue;
+        }
+        if (y [i] < -90.0 || y [i] > 90.0)
+            Rf_error ("latitudes must be between -90 and 90 degrees");
+        if (x [i] < -180.0 || x [i] > 360.0)
+            Rf_error ("longitudes must be between -180 and 360 degrees");
+    }
+
+    return na;
+}
+
+//' Per-point sines and cosines of latitudes
+//'
+//' Tables are allocated on the heap with R_alloc, and so are released at the
+//' end of the .Call, and are calculated once for each point rather than once
+//' for each pair of points.
+//'
+//' @param y Latitudes in degrees
+//' @param siny Set to table of sines, or NULL if only cosines are needed.
+//' @noRd
+void trig_tables (const double *y, size_t n, double **siny, double **cosy)
+{
+    double *c = (double *) stats_alloc (n, sizeof (double));
+    double *s = NULL;
+    if (siny != NULL)
+        s = (double *) stats_alloc (n, sizeof (double));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        c [i] = cos (y [i] * M_PI / 180.0);
+        if (s != NULL)
+            s [i] = sin (y [i] * M_PI / 180.0);
+    }
+
+    *cosy = c;
+    if (siny != NULL)
+        *siny = s;
+}
+
+//' Whether chord-based haversine kernels have been enabled with
+//' 'options (geodist.chord)'
+//'
+//' Must be called from the master thread only.
+//' @noRd
+int chord_enabled (void)
+{
+    SEXP opt = Rf_GetOption1 (Rf_install ("geodist.chord"));
+    return opt != R_NilValue && Rf_asLogical (opt) == 1;
+}
+
+//' Unit vectors of points on the sphere
+//'
+//' Calculated exactly as the projections of `nn_project()`, once for each
+//' point, so that the great circle distance between two points is
+//' `2 * earth * asin (c / 2)` for the chord length c between their vectors,
+//' without any trigonometric terms of pairs of points.
+//'
+//' @return R_alloc-ed array of (x, y, z) for each point in turn.
+//' @noRd
+double * unit_vectors (const double *x, const double *y, size_t n)
+{
+    double *u = (double *) stats_alloc (3 * n, sizeof (double));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double lon = x [i] * M_PI / 180.0, lat = y [i] * M_PI / 180.0;
+        u [3 * i] = cos (lat) * cos (lon);
+        u [3 * i + 1] = cos (lat) * sin (lon);
+        u [3 * i + 2] = sin (lat);
+    }
+
+    return u;
+}
+
+//' Constant cosine multiplier for cheap distances
+//'
+//' Cosine of the mid-point of the maximal latitude range of one or two sets of
+//' latitudes, as calculated in all cheap-distance kernels. NaN comparisons
+//' are false, and infinite latitudes skipped, so that the latitudes of
+//' missing points are ignored.
+//'
+//' @param y2 Optional second set of latitudes, or NULL with n2 = 0.
+//' @noRd
+double cheap_cosy (const double *y1, size_t n1, const double *y2, size_t n2)
+{
+    double ymin = 9999.9, ymax = -9999.9;
+
+    for (size_t i = 0; i < n1; i++)
+    {
+        if (isinf (y1 [i]))
+            continue;
+        if (y1 [i] < ymin)
+            ymin = y1 [i];
+        if (y1 [i] > ymax)
+            ymax = y1 [i];
+    }
+    for (size_t i = 0; i < n2; i++)
+    {
+        if (isinf (y2 [i]))
+            continue;
+        if (y2 [i] < ymin)
+            ymin = y2 [i];
+        if (y2 [i] > ymax)
+            ymax = y2 [i];
+    }
+    ymin = ymin * M_PI / 180;
+    ymax = ymax * M_PI / 180;
+
+    return cos ((ymin + ymax) / 2.0);
+}
+
+//' Per-point latitude-dependent terms of geodesics
+//'
+//' Allocated with R_alloc, as for `trig_tables()`, and passed to
+//' `geod_inverse_many()` or `one_geodesic_pts()`.
+//'
+//' @param x, y Longitudes and latitudes in degrees
+//' @noRd
+struct geod_point * geodesic_points (const double *x, const double *y,
+        size_t n)
+{
+    struct geod_point *p =
+        (struct geod_point *) stats_alloc (n, sizeof (struct geod_point));
+
+    for (size_t i = 0; i < n; i++)
+        geod_pointinit(&g_wgs84, p + i, y [i], x [i]);
+
+    return p;
+}
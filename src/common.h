@@ -1,12 +1,62 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <stddef.h>
+
+#include "geodesic.h"
+#include "stats.h"
+
+typedef enum
+{
+    MEASURE_HAVERSINE,
+    MEASURE_VINCENTY,
+    MEASURE_CHEAP,
+    MEASURE_GEODESIC,
+    MEASURE_RULER
+} measure_t;
+
+// Coordinates of one set of points, with the per-point terms needed by one
+// distance measure, and NULL for any which are not needed.
+typedef struct
+{
+    const double *x, *y; // longitudes and latitudes
+    const double *siny, *cosy;
+    const struct geod_point *pts;
+    size_t n;
+    const double *u; // unit vectors of haversine points; see `unit_vectors()`
+    const unsigned char *na; // missing points; see `coords_validate()`
+} point_tables;
+
+void geodesic_init (void);
+const struct geod_geodesic * geodesic_wgs84 (void);
+
 double one_haversine (double x1, double y1, double x2, double y2,
         double cosy1, double cosy2);
 double one_vincenty (double x1, double x2,
         double siny1, double cosy1, double siny2, double cosy2);
 
 double one_cheap (double x1, double y1, double x2, double y2, double cosy);
+void ruler_init (void);
+double one_ruler (double x1, double y1, double x2, double y2);
 double one_geodesic (double x1, double y1, double x2, double y2);
+double one_geodesic_azi (double x1, double y1, double x2, double y2,
+        double *azi1, double *azi2);
+double one_geodesic_pts (const struct geod_point *p1,
+        const struct geod_point *p2);
+
+void trig_tables (const double *y, size_t n, double **siny, double **cosy);
+int chord_enabled (void);
+double * unit_vectors (const double *x, const double *y, size_t n);
+double cheap_cosy (const double *y1, size_t n1, const double *y2, size_t n2);
+struct geod_point * geodesic_points (const double *x, const double *y,
+        size_t n);
+void point_tables_init (measure_t measure, const double *x, const double *y,
+        size_t n, point_tables *p);
+void point_tables_init_na (measure_t measure, const double *x, const double *y,
+        size_t n, const unsigned char *na, point_tables *p);
+void pair_tables_init (measure_t measure, const double *x, const double *y,
+        size_t n, point_tables *p);
+void point_tables_shift (const point_tables *p, size_t k, point_tables *out);
+unsigned char * coords_validate (const double *x, const double *y, size_t n);
 
 #endif /* COMMON_H */
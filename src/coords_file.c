@@ -0,0 +1,222 @@
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "coords_file.h"
+
+// One mapped file, unmapped on garbage collection, so that mappings are not
+// leaked when a calculation is interrupted.
+typedef struct
+{
+    void *addr;
+    size_t len;
+} coords_map;
+
+static void coords_map_finalizer (SEXP map_)
+{
+    coords_map *m = (coords_map *) R_ExternalPtrAddr (map_);
+    if (m)
+    {
+        if (m->addr)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile (m->addr);
+#else
+            munmap (m->addr, m->len);
+#endif
+        }
+        free (m);
+        R_ClearExternalPtr (map_);
+    }
+}
+
+//' Size of a file in bytes
+//' @return 0 if the file can not be opened, otherwise 1.
+//' @noRd
+static int coords_file_size (const char *path, double *size)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA a;
+    if (!GetFileAttributesExA (path, GetFileExInfoStandard, &a))
+        return 0;
+    *size = (double) a.nFileSizeHigh * 4294967296.0 + (double) a.nFileSizeLow;
+#else
+    struct stat st;
+    if (stat (path, &st) != 0)
+        return 0;
+    *size = (double) st.st_size;
+#endif
+    return 1;
+}
+
+//' Map a whole file read-only into memory
+//'
+//' Pages are read by the operating system on demand, and pages which are
+//' no longer needed may be discarded, so that files far larger than
+//' physical memory may be passed through the kernels.
+//'
+//' @return External pointer to a `coords_map`.
+//' @noRd
+static SEXP coords_map_file (const char *path, coords_map **out)
+{
+    double size;
+    if (!coords_file_size (path, &size))
+        Rf_error ("Unable to open file '%s'", path);
+    if (fmod (size, 2.0 * sizeof (double)) != 0.0)
+        Rf_error ("file '%s' must hold pairs of double-precision values", path);
+    size_t len = (size_t) size;
+
+    coords_map *m = (coords_map *) calloc (1, sizeof (coords_map));
+    if (!m)
+        Rf_error ("Unable to map file '%s'", path); // # nocov
+    SEXP map_ = PROTECT (R_MakeExternalPtr (m, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx (map_, coords_map_finalizer, TRUE);
+    *out = m;
+
+    // Files of no points are never mapped:
+    if (len == 0)
+    {
+        UNPROTECT (1);
+        return map_;
+    }
+
+#ifdef _WIN32
+    HANDLE f = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE)
+        Rf_error ("Unable to open file '%s'", path);
+    HANDLE h = CreateFileMappingA (f, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle (f);
+    if (h == NULL)
+        Rf_error ("Unable to map file '%s'", path);
+    // The view holds its own reference to the mapping:
+    m->addr = MapViewOfFile (h, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle (h);
+    if (m->addr == NULL)
+        Rf_error ("Unable to map file '%s'", path);
+#else
+    int fd = open (path, O_RDONLY);
+    if (fd < 0)
+        Rf_error ("Unable to open file '%s'", path);
+    void *addr = mmap (NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (addr == MAP_FAILED)
+        Rf_error ("Unable to map file '%s'", path);
+    m->addr = addr;
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise (addr, len, POSIX_MADV_SEQUENTIAL);
+#endif
+#endif
+    m->len = len;
+
+    UNPROTECT (1);
+
+    return map_;
+}
+
+//' Open coordinates of one set of points
+//'
+//' @param src_ Either the path to a binary file of native double-precision
+//' values, or a numeric vector of x-values in [1:n], y-values in [n+(1:n)].
+//' @param interleaved_ For files, 1 if values are (lon, lat) pairs of each
+//' point in turn, or 0 if all longitudes are followed by all latitudes.
+//' @return Object holding the coordinates, which must be protected for as
+//' long as `s` is used.
+//' @noRd
+SEXP coords_source_open (SEXP src_, SEXP interleaved_, coords_source *s)
+{
+    if (!Rf_isString (src_))
+    {
+        SEXP x_ = PROTECT (Rf_coerceVector (src_, REALSXP));
+        s->data = REAL (x_);
+        s->n = (size_t) (floor (length (x_) / 2));
+        s->interleaved = 0;
+        UNPROTECT (1);
+        return x_;
+    }
+
+    const char *path = R_ExpandFileName (translateChar (STRING_ELT (src_, 0)));
+    coords_map *m;
+    SEXP map_ = coords_map_file (path, &m);
+
+    s->data = (const double *) m->addr;
+    s->n = m->len / (2 * sizeof (double));
+    s->interleaved = Rf_asInteger (interleaved_) == 1;
+
+    return map_;
+}
+
+//' Number of points of a source, without opening it, for instrumented calls
+//' @noRd
+double coords_source_npoints (SEXP src_)
+{
+    if (!Rf_isString (src_))
+        return floor ((double) Rf_xlength (src_) / 2.0);
+    const char *path = R_ExpandFileName (translateChar (STRING_ELT (src_, 0)));
+    double size;
+    if (!coords_file_size (path, &size))
+        return 0.0;
+    return floor (size / (2.0 * sizeof (double)));
+}
+
+//' Longitudes and latitudes of points [i0, i0 + n) of a source
+//'
+//' Columnar coordinates are used in place, while interleaved coordinates
+//' are copied into separate longitudes and latitudes.
+//'
+//' @param buf Space for at least 2 * n values, used only for interleaved
+//' coordinates.
+//' @param x, y Set to the longitudes and latitudes of the points.
+//' @noRd
+void coords_source_chunk (const coords_source *s, size_t i0, size_t n,
+        double *buf, const double **x, const double **y)
+{
+    if (!s->interleaved)
+    {
+        *x = s->data + i0;
+        *y = s->data + s->n + i0;
+        return;
+    }
+
+    const double *xy = s->data + 2 * i0;
+    for (size_t i = 0; i < n; i++)
+    {
+        buf [i] = xy [2 * i];
+        buf [n + i] = xy [2 * i + 1];
+    }
+    *x = buf;
+    *y = buf + n;
+}
+
+//' Range of latitudes of a source, with the same comparisons as
+//' `cheap_cosy()`, which ignore NaN and infinite values
+//'
+//' @param yrange Updated in place, and so must be initialised by the caller to
+//' (9999.9, -9999.9).
+//' @noRd
+void coords_source_yrange (const coords_source *s, double *yrange)
+{
+    if (s->n == 0)
+        return;
+
+    const double *y = s->interleaved ? s->data + 1 : s->data + s->n;
+    size_t stride = s->interleaved ? 2 : 1;
+
+    for (size_t i = 0; i < s->n; i++)
+    {
+        double yi = y [i * stride];
+        if (isinf (yi))
+            continue;
+        if (yi < yrange [0])
+            yrange [0] = yi;
+        if (yi > yrange [1])
+            yrange [1] = yi;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef COORDS_FILE_H
+#define COORDS_FILE_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stddef.h>
+
+#include "common.h"
+
+// Number of points passed to the kernels at once by all calculations on
+// coordinate files, which bounds the memory of per-point terms regardless of
+// the size of the file.
+#define COORDS_CHUNK 65536
+
+// Coordinates of one set of points, either memory-mapped from a binary file
+// of native doubles, or held in an R object of x-values in [1:n], y-values in
+// [n+(1:n)].
+typedef struct
+{
+    const double *data;
+    size_t n;
+    int interleaved; // 1 for (lon, lat) pairs; 0 for all lon then all lat
+} coords_source;
+
+SEXP coords_source_open (SEXP src_, SEXP interleaved_, coords_source *s);
+double coords_source_npoints (SEXP src_);
+
+void coords_source_chunk (const coords_source *s, size_t i0, size_t n,
+        double *buf, const double **x, const double **y);
+void coords_source_yrange (const coords_source *s, double *yrange);
+
+#endif /* COORDS_FILE_H */
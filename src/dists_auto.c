@@ -0,0 +1,386 @@
+#include "dists_auto.h"
+
+// Hybrid distances for measure = "auto": Each pair is first estimated with a
+// cheap ruler scaled by the radii of curvature of the WGS-84 ellipsoid at the
+// mid-latitude of the pair, and only replaced by a full Karney geodesic where
+// the error of that estimate may exceed the tolerance.
+//
+// The relative error of the ruler grows with the square of the distance, d,
+// and with the square of the secant of the mid-latitude, phi, and is bounded
+// by AUTO_K * (d / a) ^ 2 / cos ^ 2 (phi), with 'a' the equatorial radius.
+// The maximal observed value of that constant over all latitudes and azimuths
+// is around 0.047, approached at high latitudes, so 1 / 16 includes a margin
+// of around one third.
+#define AUTO_K 0.0625
+
+typedef struct
+{
+    point_tables p1, p2;
+    double tol; // squared distance limit, tol * a ^ 2 / AUTO_K
+} auto_ctx;
+
+//' Point tables of geodesics, along with the sines and cosines of latitudes
+//' of the ruler, and the mask of missing points
+//' @noRd
+static point_tables auto_points (const double *x, const double *y, size_t n)
+{
+    point_tables p;
+    double *siny, *cosy;
+
+    point_tables_init (MEASURE_GEODESIC, x, y, n, &p);
+    trig_tables (y, n, &siny, &cosy);
+    p.siny = siny;
+    p.cosy = cosy;
+
+    return p;
+}
+
+static auto_ctx auto_init (point_tables p1, point_tables p2, SEXP tol_)
+{
+    auto_ctx c;
+
+    c.p1 = p1;
+    c.p2 = p2;
+    c.tol = Rf_asReal (tol_) * earth * earth / AUTO_K;
+
+    return c;
+}
+
+//' Hybrid distance between point i of p1 and point j of p2
+//'
+//' The squared cosine of the mid-latitude is calculated from the tables as
+//' cos ^ 2 ((y1 + y2) / 2) = (1 + cos (y1 + y2)) / 2, and the ruler is accepted
+//' if (d / a) ^ 2 / cos ^ 2 (phi) is within tolerance, and otherwise replaced
+//' by the geodesic pair kernel of kernels.h. Distances of missing points are
+//' overwritten with NA by the traversals.
+//' @noRd
+static inline double one_auto (const auto_ctx *c, size_t i, size_t j)
+{
+    const double e2 = flattening * (2.0 - flattening);
+    const double m = earth * M_PI / 180.0; // metres per degree
+
+    double cos2m = 0.5 * (1.0 + c->p1.cosy [i] * c->p2.cosy [j] -
+            c->p1.siny [i] * c->p2.siny [j]);
+    double w2 = 1.0 / (1.0 - e2 * (1.0 - cos2m));
+    double w = sqrt (w2);
+    double kx = m * w * sqrt (cos2m);
+    double ky = m * w * w2 * (1.0 - e2);
+
+    double dlon = c->p2.x [j] - c->p1.x [i];
+    if (dlon > 180.0)
+        dlon -= 360.0;
+    else if (dlon < -180.0)
+        dlon += 360.0;
+    double dx = dlon * kx;
+    double dy = (c->p2.y [j] - c->p1.y [i]) * ky;
+    double d2 = dx * dx + dy * dy;
+
+    if (d2 <= c->tol * cos2m)
+        return sqrt (d2);
+
+    return kernel_pair (MEASURE_GEODESIC, &c->p1, i, &c->p2, j, 0.0);
+}
+
+//' Hybrid distances between point i of p1 and points [j0, j0 + n) of p2, with
+//' NA for missing points of either; see `point_na()`
+//' @noRd
+static void auto_row (const auto_ctx *c, size_t i, size_t j0, size_t n,
+        double *out)
+{
+    if (point_na (&c->p1, i))
+    {
+        na_fill (out, n);
+        return;
+    }
+    for (size_t j = 0; j < n; j++)
+        out [j] = one_auto (c, i, j0 + j);
+    na_mask_row (&c->p2, j0, n, out);
+}
+
+//' Full matrix of hybrid distances between p1 and p2
+//'
+//' Rows are scheduled dynamically, as the proportion of pairs refined with
+//' geodesics may vary between rows.
+//'
+//' @param symmetric If true, p1 and p2 are identical, and only the upper
+//' triangle is calculated and mirrored into the lower triangle.
+//' @noRd
+static void auto_full (const auto_ctx *c, size_t n1, size_t n2,
+        int symmetric, int nthreads, double *rout)
+{
+    size_t nblocks;
+    size_t *blocks;
+    volatile int interrupted = 0;
+
+    if (symmetric)
+    {
+        for (size_t i = 0; i < n1; i++)
+            rout [i * n1 + i] = 0.0;
+        blocks = tri_row_blocks (n1, nthreads, &nblocks);
+    } else
+        blocks = row_blocks (n1, nthreads, &nblocks);
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            if (symmetric)
+            {
+                auto_row (c, i, i + 1, n1 - i - 1, rout + i * n1 + i + 1);
+                for (size_t j = i + 1; j < n1; j++)
+                    rout [j * n1 + i] = rout [i * n1 + j];
+            } else
+                auto_row (c, i, 0, n2, rout + i * n2);
+        }
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Paired hybrid distances between p1 and p2
+//' @noRd
+static void auto_paired (const auto_ctx *c, size_t n, int nthreads,
+        double *rout)
+{
+    size_t nblocks;
+    size_t *blocks = row_blocks (n, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        size_t i0 = blocks [b], nb = blocks [b + 1] - blocks [b];
+        for (size_t i = i0; i < i0 + nb; i++)
+            rout [i] = one_auto (c, i, i);
+        na_mask_pairs (&c->p1, &c->p2, i0, nb, rout + i0);
+    }
+    end_check_interrupt (interrupted);
+}
+
+static SEXP auto_x (const double *rx, const double *ry, size_t n,
+        SEXP tol_, int nthreads)
+{
+    SEXP out = PROTECT (allocVector (REALSXP, n * n));
+
+    point_tables p = auto_points (rx, ry, n);
+    auto_ctx c = auto_init (p, p, tol_);
+    auto_full (&c, n, n, 1, nthreads, REAL (out));
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+static SEXP auto_xy (const double *rx1, const double *ry1, size_t n1,
+        const double *rx2, const double *ry2, size_t n2,
+        SEXP tol_, int nthreads)
+{
+    SEXP out = PROTECT (allocVector (REALSXP, n1 * n2));
+
+    auto_ctx c = auto_init (auto_points (rx1, ry1, n1),
+            auto_points (rx2, ry2, n2), tol_);
+    auto_full (&c, n1, n2, 0, nthreads, REAL (out));
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+static SEXP auto_pair (const double *rx1, const double *ry1,
+        const double *rx2, const double *ry2, size_t n,
+        SEXP tol_, int nthreads)
+{
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+
+    auto_ctx c = auto_init (auto_points (rx1, ry1, n),
+            auto_points (rx2, ry2, n), tol_);
+    auto_paired (&c, n, nthreads, REAL (out));
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+//' Sequential hybrid distances, as paired distances between the points
+//' offset by one, the first of which is NA.
+//' @noRd
+static SEXP auto_seq (const double *rx, const double *ry, size_t n,
+        SEXP tol_, int nthreads)
+{
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+
+    if (n > 0)
+    {
+        point_tables p = auto_points (rx, ry, n), p1;
+        point_tables_shift (&p, 1, &p1);
+        auto_ctx c = auto_init (p, p1, tol_);
+        REAL (out) [0] = NA_REAL;
+        auto_paired (&c, n - 1, nthreads, REAL (out) + 1);
+    }
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+//' R_auto
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto (SEXP x_, SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    SEXP out = PROTECT (auto_x (REAL (x_), REAL (x_) + n, n,
+                tol_, nthreads));
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_auto_xy
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_xy (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_)
+{
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (auto_xy (REAL (x_), REAL (x_) + nx, nx,
+                REAL (y_), REAL (y_) + ny, ny, tol_, nthreads));
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_auto_paired
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_paired (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (auto_pair (REAL (x_), REAL (x_) + n,
+                REAL (y_), REAL (y_) + n, n, tol_, nthreads));
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_auto_seq
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_seq (SEXP x_, SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    SEXP out = PROTECT (auto_seq (REAL (x_), REAL (x_) + n, n,
+                tol_, nthreads));
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_auto_vec
+//' @param x_, y_ Vectors of x- and y-values
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_vec (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) length (x_);
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (auto_x (REAL (x_), REAL (y_), n, tol_, nthreads));
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_auto_xy_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP tol_, SEXP threads_)
+{
+    size_t n1 = (size_t) length (x1_);
+    size_t n2 = (size_t) length (x2_);
+    int nthreads = get_num_threads (threads_);
+
+    x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
+    y1_ = PROTECT (Rf_coerceVector (y1_, REALSXP));
+    x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
+    y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
+    SEXP out = PROTECT (auto_xy (REAL (x1_), REAL (y1_), n1,
+                REAL (x2_), REAL (y2_), n2, tol_, nthreads));
+    UNPROTECT (5);
+
+    return out;
+}
+
+//' R_auto_paired_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) length (x1_);
+    int nthreads = get_num_threads (threads_);
+
+    x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
+    y1_ = PROTECT (Rf_coerceVector (y1_, REALSXP));
+    x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
+    y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
+    SEXP out = PROTECT (auto_pair (REAL (x1_), REAL (y1_),
+                REAL (x2_), REAL (y2_), n, tol_, nthreads));
+    UNPROTECT (5);
+
+    return out;
+}
+
+//' R_auto_seq_vec
+//' @param x_, y_ Vectors of x- and y-values
+//' @param tol_ Maximal relative error of ruler distances
+//' @noRd
+SEXP R_auto_seq_vec (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_)
+{
+    size_t n = (size_t) length (x_);
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (auto_seq (REAL (x_), REAL (y_), n, tol_, nthreads));
+    UNPROTECT (3);
+
+    return out;
+}
@@ -0,0 +1,27 @@
+#ifndef DISTS_AUTO_H
+#define DISTS_AUTO_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <math.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "geodesic.h"
+#include "threads.h"
+#include "kernels.h"
+
+SEXP R_auto (SEXP x_, SEXP tol_, SEXP threads_);
+SEXP R_auto_xy (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_);
+SEXP R_auto_paired (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_);
+SEXP R_auto_seq (SEXP x_, SEXP tol_, SEXP threads_);
+
+SEXP R_auto_vec (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_);
+SEXP R_auto_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP tol_, SEXP threads_);
+SEXP R_auto_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP tol_, SEXP threads_);
+SEXP R_auto_seq_vec (SEXP x_, SEXP y_, SEXP tol_, SEXP threads_);
+
+#endif /* DISTS_AUTO_H */
@@ -0,0 +1,220 @@
+#include "dists_azimuth.h"
+
+//' List of distances, and azimuths at the first and second points of each
+//' pair, as three vectors of n values, or (n * ny) matrices if 'matrix' is
+//' non-zero
+//' @noRd
+static SEXP azimuth_list (size_t n, size_t ny, int matrix)
+{
+    SEXP out = PROTECT (allocVector (VECSXP, 3));
+    SEXP nms = PROTECT (allocVector (STRSXP, 3));
+    const char *names [3] = {"distance", "azimuth1", "azimuth2"};
+    for (int k = 0; k < 3; k++)
+    {
+        SET_VECTOR_ELT (out, k, matrix ?
+                allocMatrix (REALSXP, (int) n, (int) ny) :
+                allocVector (REALSXP, n));
+        SET_STRING_ELT (nms, k, mkChar (names [k]));
+    }
+    setAttrib (out, R_NamesSymbol, nms);
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' Paired geodesics and azimuths between points [0, n) of (x1, y1) and the
+//' same points of (x2, y2), each from a single `geod_inverse()` evaluation
+//'
+//' Costs vary with the separation of the points, and so blocks are
+//' scheduled dynamically, as for `kernel_paired_dists()`.
+//'
+//' @param na1, na2 Masks of missing points from `coords_validate()`, or NULL.
+//' Pairs with either point missing are not evaluated, and are NA.
+//' @noRd
+static void paired_azimuths (const double *x1, const double *y1,
+        const double *x2, const double *y2, const unsigned char *na1,
+        const unsigned char *na2, size_t n, int nthreads, double *d,
+        double *azi1, double *azi2)
+{
+    size_t nblocks;
+    size_t *blocks = row_blocks (n, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            if ((na1 != NULL && na1 [i]) || (na2 != NULL && na2 [i]))
+                d [i] = azi1 [i] = azi2 [i] = NA_REAL;
+            else
+                d [i] = one_geodesic_azi (x1 [i], y1 [i], x2 [i], y2 [i],
+                        azi1 + i, azi2 + i);
+        }
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' R_geodesic_xy_azimuth
+//'
+//' Rows of y are passed to `geod_inverse_many_azi()` in segments of TILE_NY
+//' points, so that the latitude-dependent terms of each point are calculated
+//' only once, and transposed from per-thread buffers into the column-major
+//' result matrices. Rows of missing points of x are not evaluated, and
+//' segments are split around missing points of y, so that only pairs of
+//' complete points are passed to `geod_inverse_many_azi()`, and all others
+//' are NA.
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @return List of (nx * ny) matrices of distances, and of azimuths at points
+//' of x and of y.
+//' @noRd
+SEXP R_geodesic_xy_azimuth (SEXP x_, SEXP y_, SEXP threads_)
+{
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (azimuth_list (nx, ny, 1));
+    double *d = REAL (VECTOR_ELT (out, 0));
+    double *azi1 = REAL (VECTOR_ELT (out, 1));
+    double *azi2 = REAL (VECTOR_ELT (out, 2));
+
+    double *rx = REAL (x_), *ry = REAL (y_);
+    const unsigned char *na1 = coords_validate (rx, rx + nx, nx);
+    const unsigned char *na2 = coords_validate (ry, ry + ny, ny);
+    struct geod_point *p1 = geodesic_points (rx, rx + nx, nx);
+    struct geod_point *p2 = geodesic_points (ry, ry + ny, ny);
+    double *scratch = tile_scratch (nthreads);
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (nx, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        double *buf = scratch + omp_get_thread_num () * 4 * TILE_NY;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            if (na1 != NULL && na1 [i])
+            {
+                for (size_t j = 0; j < ny; j++)
+                {
+                    size_t ij = i + j * nx;
+                    d [ij] = azi1 [ij] = azi2 [ij] = NA_REAL;
+                }
+                continue;
+            }
+            for (size_t j0 = 0; j0 < ny; j0 += TILE_NY)
+            {
+                size_t n = (ny - j0 < TILE_NY) ? ny - j0 : TILE_NY;
+                const unsigned char *na = (na2 != NULL) ? na2 + j0 : NULL;
+                // Runs [k0, k1) of complete points of y:
+                for (size_t k0 = 0; k0 < n; )
+                {
+                    if (na != NULL && na [k0])
+                    {
+                        k0++;
+                        continue;
+                    }
+                    size_t k1 = k0 + 1;
+                    while (k1 < n && !(na != NULL && na [k1]))
+                        k1++;
+                    geod_inverse_many_azi (geodesic_wgs84 (), p1 + i, k1 - k0,
+                            p2 + j0 + k0, buf + k0, buf + TILE_NY + k0,
+                            buf + 2 * TILE_NY + k0);
+                    k0 = k1;
+                }
+                for (size_t k = 0; k < n; k++)
+                {
+                    size_t ij = i + (j0 + k) * nx;
+                    if (na != NULL && na [k])
+                    {
+                        d [ij] = azi1 [ij] = azi2 [ij] = NA_REAL;
+                        continue;
+                    }
+                    d [ij] = buf [k];
+                    azi1 [ij] = buf [TILE_NY + k];
+                    azi2 [ij] = buf [2 * TILE_NY + k];
+                }
+            }
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_geodesic_paired_azimuth
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @return List of vectors of paired distances, and of azimuths at points of
+//' x and of y.
+//' @noRd
+SEXP R_geodesic_paired_azimuth (SEXP x_, SEXP y_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    SEXP out = PROTECT (azimuth_list (n, 0, 0));
+
+    double *rx = REAL (x_), *ry = REAL (y_);
+    const unsigned char *na1 = coords_validate (rx, rx + n, n);
+    const unsigned char *na2 = coords_validate (ry, ry + n, n);
+    paired_azimuths (rx, rx + n, ry, ry + n, na1, na2, n, nthreads,
+            REAL (VECTOR_ELT (out, 0)), REAL (VECTOR_ELT (out, 1)),
+            REAL (VECTOR_ELT (out, 2)));
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_geodesic_seq_azimuth
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @return List of vectors of sequential distances, and of azimuths at the
+//' start and end of each step, with initial values of NA.
+//' @noRd
+SEXP R_geodesic_seq_azimuth (SEXP x_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    SEXP out = PROTECT (azimuth_list (n, 0, 0));
+
+    if (n > 0)
+    {
+        double *rx = REAL (x_), *ry = rx + n;
+        const unsigned char *na = coords_validate (rx, ry, n);
+        double *d = REAL (VECTOR_ELT (out, 0));
+        double *azi1 = REAL (VECTOR_ELT (out, 1));
+        double *azi2 = REAL (VECTOR_ELT (out, 2));
+        d [0] = azi1 [0] = azi2 [0] = NA_REAL;
+        paired_azimuths (rx, ry, rx + 1, ry + 1, na,
+                (na != NULL) ? na + 1 : NULL, n - 1, nthreads, d + 1,
+                azi1 + 1, azi2 + 1);
+    }
+
+    UNPROTECT (2);
+
+    return out;
+}
@@ -0,0 +1,16 @@
+#ifndef DISTS_AZIMUTH_H
+#define DISTS_AZIMUTH_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "tiles.h"
+
+SEXP R_geodesic_xy_azimuth (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_paired_azimuth (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_seq_azimuth (SEXP x_, SEXP threads_);
+
+#endif /* DISTS_AZIMUTH_H */
@@ -0,0 +1,444 @@
+#include "dists_file.h"
+
+// All calculations pass coordinates through the kernels in chunks of
+// COORDS_CHUNK points, with the per-point terms of each chunk released with
+// vmaxset() once it is done, so that the memory used beyond the mapped files
+// is that of the results alone.
+
+//' Constant cosine multiplier for cheap distances between all points of one
+//' or two sources, identical to `cheap_cosy()` of the same coordinates
+//' @noRd
+static double file_cosy (measure_t measure, const coords_source *s1,
+        const coords_source *s2)
+{
+    if (measure != MEASURE_CHEAP)
+        return 0.0;
+
+    double yrange [2] = { 9999.9, -9999.9 };
+    coords_source_yrange (s1, yrange);
+    if (s2 != NULL)
+        coords_source_yrange (s2, yrange);
+    return cheap_cosy (yrange, (yrange [0] <= yrange [1]) ? 2 : 0, NULL, 0);
+}
+
+//' Sequential distances along the points of a source
+//'
+//' Successive chunks overlap by one point, so that each distance is
+//' calculated exactly as by `seq_dists()`.
+//'
+//' @return Vector of n distances, the first of which is NA.
+//' @noRd
+static SEXP file_seq (measure_t measure, SEXP x_, SEXP interleaved_,
+        SEXP threads_)
+{
+    int nthreads = get_num_threads (threads_);
+    coords_source s;
+    PROTECT (coords_source_open (x_, interleaved_, &s));
+    size_t n = s.n;
+
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+    double *rout = REAL (out);
+    if (n > 0)
+        rout [0] = NA_REAL;
+
+    double cosy = file_cosy (measure, &s, NULL);
+    double *buf = (double *) stats_alloc (2 * (COORDS_CHUNK + 1),
+            sizeof (double));
+
+    for (size_t i0 = 0; i0 + 1 < n; i0 += COORDS_CHUNK)
+    {
+        R_CheckUserInterrupt ();
+        size_t m = (i0 + COORDS_CHUNK + 1 < n) ? COORDS_CHUNK + 1 : n - i0;
+        const void *vmax = vmaxget ();
+
+        const double *x, *y;
+        coords_source_chunk (&s, i0, m, buf, &x, &y);
+        point_tables p1, p2;
+        pair_tables_init (measure, x, y, m, &p1);
+        point_tables_shift (&p1, 1, &p2);
+        kernel_paired_dists (measure, &p1, &p2, cosy, nthreads,
+                rout + i0 + 1);
+
+        vmaxset (vmax);
+    }
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' Paired distances between the points of two sources
+//' @noRd
+static SEXP file_paired (measure_t measure, SEXP x_, SEXP y_,
+        SEXP interleaved_, SEXP threads_)
+{
+    int nthreads = get_num_threads (threads_);
+    coords_source s1, s2;
+    PROTECT (coords_source_open (x_, interleaved_, &s1));
+    PROTECT (coords_source_open (y_, interleaved_, &s2));
+    if (s1.n != s2.n)
+        Rf_error ("x and y must have the same number of points");
+    size_t n = s1.n;
+
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+    double *rout = REAL (out);
+
+    double cosy = file_cosy (measure, &s1, &s2);
+    double *buf1 = (double *) stats_alloc (2 * COORDS_CHUNK, sizeof (double));
+    double *buf2 = (double *) stats_alloc (2 * COORDS_CHUNK, sizeof (double));
+
+    for (size_t i0 = 0; i0 < n; i0 += COORDS_CHUNK)
+    {
+        R_CheckUserInterrupt ();
+        size_t m = (i0 + COORDS_CHUNK < n) ? COORDS_CHUNK : n - i0;
+        const void *vmax = vmaxget ();
+
+        const double *x1, *y1, *x2, *y2;
+        coords_source_chunk (&s1, i0, m, buf1, &x1, &y1);
+        coords_source_chunk (&s2, i0, m, buf2, &x2, &y2);
+        point_tables p1, p2;
+        pair_tables_init (measure, x1, y1, m, &p1);
+        pair_tables_init (measure, x2, y2, m, &p2);
+        kernel_paired_dists (measure, &p1, &p2, cosy, nthreads, rout + i0);
+
+        vmaxset (vmax);
+    }
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' Minimal and maximal sequential distances along the points of a source,
+//' without holding the distances themselves
+//' @noRd
+static SEXP file_range (measure_t measure, SEXP x_, SEXP interleaved_)
+{
+    coords_source s;
+    PROTECT (coords_source_open (x_, interleaved_, &s));
+    size_t n = s.n;
+
+    SEXP out = PROTECT (allocVector (REALSXP, 2));
+    double *range = REAL (out);
+    range [0] = 100.0 * equator;
+    range [1] = -100.0 * equator;
+
+    double cosy = file_cosy (measure, &s, NULL);
+    double *buf = (double *) stats_alloc (2 * (COORDS_CHUNK + 1),
+            sizeof (double));
+
+    for (size_t i0 = 0; i0 + 1 < n; i0 += COORDS_CHUNK)
+    {
+        R_CheckUserInterrupt ();
+        size_t m = (i0 + COORDS_CHUNK + 1 < n) ? COORDS_CHUNK + 1 : n - i0;
+        const void *vmax = vmaxget ();
+
+        const double *x, *y;
+        coords_source_chunk (&s, i0, m, buf, &x, &y);
+        point_tables p;
+        pair_tables_init (measure, x, y, m, &p);
+        double r [2];
+        kernel_seq_range (measure, &p, cosy, r);
+        if (r [0] < range [0])
+            range [0] = r [0];
+        if (r [1] > range [1])
+            range [1] = r [1];
+
+        vmaxset (vmax);
+    }
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' Nearest point of y to each point of x
+//'
+//' Points of y are searched in no particular order, and so are held in
+//' memory, with interleaved coordinates copied into separate longitudes and
+//' latitudes, while points of x are passed in chunks. The kd-tree or the
+//' tables of y are built once only, under the same conditions as for
+//' `xy_min()`, so that results are identical, and ruler distances are
+//' always scanned by brute force.
+//'
+//' @return Vector of 1-based indices into y, or NA.
+//' @noRd
+static SEXP file_min (measure_t measure, SEXP x_, SEXP y_,
+        SEXP interleaved_, SEXP threads_)
+{
+    int nthreads = get_num_threads (threads_);
+    coords_source s1, s2;
+    PROTECT (coords_source_open (x_, interleaved_, &s1));
+    PROTECT (coords_source_open (y_, interleaved_, &s2));
+    size_t nx = s1.n, ny = s2.n;
+
+    SEXP out = PROTECT (allocVector (INTSXP, nx));
+    int *iout = INTEGER (out);
+
+    const double *rx2, *ry2;
+    double *buf2 = s2.interleaved ?
+        (double *) stats_alloc (2 * ny, sizeof (double)) : NULL;
+    coords_source_chunk (&s2, 0, ny, buf2, &rx2, &ry2);
+
+    double cosy = file_cosy (measure, &s1, &s2);
+
+    const unsigned char *na2 = coords_validate (rx2, ry2, ny);
+    int use_tree = measure != MEASURE_RULER && (na2 == NULL) &&
+        nn_use_tree (nx, ny);
+    SEXP tree_ = PROTECT (use_tree ?
+            nn_tree_create (rx2, ry2, ny, measure, cosy) : R_NilValue);
+    point_tables p2;
+    if (!use_tree)
+        point_tables_init_na (measure, rx2, ry2, ny, na2, &p2);
+
+    double *buf1 = (double *) stats_alloc (2 * COORDS_CHUNK, sizeof (double));
+
+    for (size_t i0 = 0; i0 < nx; i0 += COORDS_CHUNK)
+    {
+        R_CheckUserInterrupt ();
+        size_t m = (i0 + COORDS_CHUNK < nx) ? COORDS_CHUNK : nx - i0;
+        const void *vmax = vmaxget ();
+
+        const double *x1, *y1;
+        coords_source_chunk (&s1, i0, m, buf1, &x1, &y1);
+        if (use_tree)
+        {
+            coords_validate (x1, y1, m);
+            xy_min_tree_search (nn_tree_get (tree_), x1, y1, m, nthreads,
+                    iout + i0);
+        } else
+        {
+            point_tables p1;
+            point_tables_init (measure, x1, y1, m, &p1);
+            xy_min_tables (measure, &p1, &p2, cosy, nthreads, iout + i0);
+        }
+
+        vmaxset (vmax);
+    }
+
+    UNPROTECT (4);
+
+    return out;
+}
+
+//' R_haversine_file_seq
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_haversine_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_)
+{
+    return file_seq (MEASURE_HAVERSINE, x_, interleaved_, threads_);
+}
+
+//' R_vincenty_file_seq
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_vincenty_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_)
+{
+    return file_seq (MEASURE_VINCENTY, x_, interleaved_, threads_);
+}
+
+//' R_cheap_file_seq
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_cheap_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_)
+{
+    return file_seq (MEASURE_CHEAP, x_, interleaved_, threads_);
+}
+
+//' R_geodesic_file_seq
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_geodesic_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_)
+{
+    return file_seq (MEASURE_GEODESIC, x_, interleaved_, threads_);
+}
+
+//' R_ruler_file_seq
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_ruler_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_)
+{
+    return file_seq (MEASURE_RULER, x_, interleaved_, threads_);
+}
+
+//' R_haversine_file_paired
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_haversine_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_)
+{
+    return file_paired (MEASURE_HAVERSINE, x_, y_, interleaved_, threads_);
+}
+
+//' R_vincenty_file_paired
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_vincenty_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_)
+{
+    return file_paired (MEASURE_VINCENTY, x_, y_, interleaved_, threads_);
+}
+
+//' R_cheap_file_paired
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_cheap_file_paired (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_paired (MEASURE_CHEAP, x_, y_, interleaved_, threads_);
+}
+
+//' R_geodesic_file_paired
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_geodesic_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_)
+{
+    return file_paired (MEASURE_GEODESIC, x_, y_, interleaved_, threads_);
+}
+
+//' R_ruler_file_paired
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_ruler_file_paired (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_paired (MEASURE_RULER, x_, y_, interleaved_, threads_);
+}
+
+//' R_haversine_file_range
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_haversine_file_range (SEXP x_, SEXP interleaved_)
+{
+    return file_range (MEASURE_HAVERSINE, x_, interleaved_);
+}
+
+//' R_vincenty_file_range
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_vincenty_file_range (SEXP x_, SEXP interleaved_)
+{
+    return file_range (MEASURE_VINCENTY, x_, interleaved_);
+}
+
+//' R_cheap_file_range
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_cheap_file_range (SEXP x_, SEXP interleaved_)
+{
+    return file_range (MEASURE_CHEAP, x_, interleaved_);
+}
+
+//' R_geodesic_file_range
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_geodesic_file_range (SEXP x_, SEXP interleaved_)
+{
+    return file_range (MEASURE_GEODESIC, x_, interleaved_);
+}
+
+//' R_ruler_file_range
+//' @param x_ Path of a coordinate file, or single vector of x-values in
+//' [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_ruler_file_range (SEXP x_, SEXP interleaved_)
+{
+    return file_range (MEASURE_RULER, x_, interleaved_);
+}
+
+//' R_haversine_file_min
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_haversine_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_min (MEASURE_HAVERSINE, x_, y_, interleaved_, threads_);
+}
+
+//' R_vincenty_file_min
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_vincenty_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_min (MEASURE_VINCENTY, x_, y_, interleaved_, threads_);
+}
+
+//' R_cheap_file_min
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_cheap_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_min (MEASURE_CHEAP, x_, y_, interleaved_, threads_);
+}
+
+//' R_geodesic_file_min
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_geodesic_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_min (MEASURE_GEODESIC, x_, y_, interleaved_, threads_);
+}
+
+//' R_ruler_file_min
+//' @param x_, y_ Paths of coordinate files, or single vectors of x-values
+//' in [1:n], y-values in [n+(1:n)]
+//' @param interleaved_ 1 for (lon, lat) pairs in files, 0 for columns
+//' @noRd
+SEXP R_ruler_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_)
+{
+    return file_min (MEASURE_RULER, x_, y_, interleaved_, threads_);
+}
+
+//' Numbers of pairs of points of coordinate files or vectors, for
+//' instrumented calls
+//' @noRd
+double stats_pairs_file_seq (SEXP x_)
+{
+    double n = coords_source_npoints (x_);
+    return (n > 0.0) ? n - 1.0 : 0.0;
+}
+
+double stats_pairs_file_paired (SEXP x_)
+{
+    return coords_source_npoints (x_);
+}
+
+double stats_pairs_file_xy (SEXP x_, SEXP y_)
+{
+    return coords_source_npoints (x_) * coords_source_npoints (y_);
+}
@@ -0,0 +1,52 @@
+#ifndef DISTS_FILE_H
+#define DISTS_FILE_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "threads.h"
+#include "stats.h"
+#include "kernels.h"
+#include "coords_file.h"
+#include "dists_xy_min.h"
+
+SEXP R_haversine_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_);
+SEXP R_vincenty_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_);
+SEXP R_cheap_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_);
+SEXP R_geodesic_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_);
+SEXP R_ruler_file_seq (SEXP x_, SEXP interleaved_, SEXP threads_);
+
+SEXP R_haversine_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_vincenty_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_cheap_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_geodesic_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_ruler_file_paired (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+
+SEXP R_haversine_file_range (SEXP x_, SEXP interleaved_);
+SEXP R_vincenty_file_range (SEXP x_, SEXP interleaved_);
+SEXP R_cheap_file_range (SEXP x_, SEXP interleaved_);
+SEXP R_geodesic_file_range (SEXP x_, SEXP interleaved_);
+SEXP R_ruler_file_range (SEXP x_, SEXP interleaved_);
+
+SEXP R_haversine_file_min (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_vincenty_file_min (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_cheap_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_);
+SEXP R_geodesic_file_min (SEXP x_, SEXP y_, SEXP interleaved_,
+        SEXP threads_);
+SEXP R_ruler_file_min (SEXP x_, SEXP y_, SEXP interleaved_, SEXP threads_);
+
+double stats_pairs_file_seq (SEXP x_);
+double stats_pairs_file_paired (SEXP x_);
+double stats_pairs_file_xy (SEXP x_, SEXP y_);
+
+#endif /* DISTS_FILE_H */
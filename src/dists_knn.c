@@ -0,0 +1,365 @@
+#include <string.h>
+
+#include "dists_knn.h"
+
+//' k nearest neighbours in a kd-tree of each point of (x, y)
+//'
+//' @return List of two (nx, k) matrices: 1-based integer indices into the
+//' points of the tree, and distances. Where fewer than k neighbours exist,
+//' remaining values are NA.
+//' @noRd
+SEXP knn_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, size_t k)
+{
+    double *rd;
+    int *ri;
+
+    stats_counting ();
+
+    SEXP index = PROTECT (allocMatrix (INTSXP, (int) nx, (int) k));
+    SEXP dist = PROTECT (allocMatrix (REALSXP, (int) nx, (int) k));
+    ri = INTEGER (index);
+    rd = REAL (dist);
+
+    nn_match *res = (nn_match *) stats_alloc (k, sizeof (nn_match));
+
+    for (size_t i = 0; i < nx; i++)
+    {
+        if (i % 1000 == 0)
+            R_CheckUserInterrupt (); // # nocov
+
+        size_t n = nn_knn (t, x [i], y [i], k, res);
+        if (n == NN_FAILED)
+            Rf_error ("kd-tree search failed"); // # nocov
+        for (size_t j = 0; j < k; j++)
+        {
+            ri [j * nx + i] = (j < n) ? (int) res [j].j + 1L : NA_INTEGER;
+            rd [j * nx + i] = (j < n) ? res [j].d : NA_REAL;
+        }
+    }
+
+    SEXP out = PROTECT (allocVector (VECSXP, 2));
+    SET_VECTOR_ELT (out, 0, index);
+    SET_VECTOR_ELT (out, 1, dist);
+
+    SEXP nms = PROTECT (allocVector (STRSXP, 2));
+    SET_STRING_ELT (nms, 0, mkChar ("index"));
+    SET_STRING_ELT (nms, 1, mkChar ("distance"));
+    setAttrib (out, R_NamesSymbol, nms);
+
+    UNPROTECT (4);
+
+    return out;
+}
+
+//' Free the heap arrays of matches of each block of rows
+//' @noRd
+static void within_free (nn_matches *res, size_t nblocks)
+{
+    for (size_t b = 0; b < nblocks; b++)
+        free (res [b].m);
+}
+
+//' All points of a spatial index within a given distance of each query point
+//'
+//' Rows are searched in blocks in parallel, each block appending matches to
+//' its own growable array, and the matches of each row are then copied in
+//' order of rows, so that results are identical for any number of threads.
+//'
+//' @param t, g Either a kd-tree searched with the coordinates (x, y), or a
+//' grid searched with the point tables p, with the other NULL.
+//' @param order Optional order in which to search the rows, or NULL to search
+//' all rows in order. Rows which are not included have no matches.
+//' @param norder Number of rows to search.
+//' @param radius Maximal distance in metres
+//' @param upper If non-zero, the query points are the points of the index,
+//' and only matches with indices greater than the index of each point are
+//' kept, giving each pair of the upper triangle once only.
+//' @return List of three vectors: 1-based integer indices into the query
+//' points and the points of the index, and distances, ordered by query points
+//' then points of the index.
+//' @noRd
+static SEXP within_search (const nn_tree *t, const nn_grid *g,
+        const point_tables *p, const double *x, const double *y, size_t nx,
+        const size_t *order, size_t norder, double radius, int upper,
+        int nthreads)
+{
+    stats_counting ();
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (norder, nthreads, &nblocks);
+    nn_matches *res = (nn_matches *) stats_alloc (nblocks,
+            sizeof (nn_matches));
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        nn_matches r = { NULL, 0, 0, 1, 0 };
+        res [b] = r;
+    }
+    // Block of each row, and range of its matches within the array of that
+    // block:
+    size_t *row_block = (size_t *) stats_alloc (nx, sizeof (size_t));
+    size_t *row_start = (size_t *) stats_alloc (nx, sizeof (size_t));
+    size_t *row_end = (size_t *) stats_alloc (nx, sizeof (size_t));
+    memset (row_block, 0, nx * sizeof (size_t));
+    memset (row_start, 0, nx * sizeof (size_t));
+    memset (row_end, 0, nx * sizeof (size_t));
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        nn_matches *rb = res + b;
+        for (size_t q = blocks [b]; q < blocks [b + 1] && !rb->failed; q++)
+        {
+            size_t i = order ? order [q] : q;
+            size_t n0 = rb->n;
+            if (g)
+                nn_grid_within (g, p, i, radius, rb);
+            else
+                nn_within (t, x [i], y [i], radius, rb);
+            if (upper)
+            {
+                // Matches are in order of increasing index:
+                size_t k = n0;
+                while (k < rb->n && rb->m [k].j <= i)
+                    k++;
+                memmove (rb->m + n0, rb->m + k,
+                        (rb->n - k) * sizeof (nn_match));
+                rb->n -= k - n0;
+            }
+            row_block [i] = b;
+            row_start [i] = n0;
+            row_end [i] = rb->n;
+        }
+    }
+
+    int failed = 0;
+    size_t ntot = 0;
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        failed = failed || res [b].failed;
+        ntot += res [b].n;
+        stats_add_bytes ((double) res [b].capacity * sizeof (nn_match));
+    }
+    if (failed || interrupted)
+    {
+        within_free (res, nblocks);
+        if (failed)
+            Rf_error ("Unable to search for pairs of points"); // # nocov
+        end_check_interrupt (interrupted);
+    }
+
+    SEXP out_i = PROTECT (allocVector (INTSXP, ntot));
+    SEXP out_j = PROTECT (allocVector (INTSXP, ntot));
+    SEXP out_d = PROTECT (allocVector (REALSXP, ntot));
+    int *ri = INTEGER (out_i), *rj = INTEGER (out_j);
+    double *rd = REAL (out_d);
+
+    size_t pos = 0;
+    for (size_t i = 0; i < nx; i++)
+    {
+        const nn_match *m = res [row_block [i]].m;
+        for (size_t k = row_start [i]; k < row_end [i]; k++, pos++)
+        {
+            ri [pos] = (int) i + 1L;
+            rj [pos] = (int) m [k].j + 1L;
+            rd [pos] = m [k].d;
+        }
+    }
+    within_free (res, nblocks);
+
+    SEXP out = PROTECT (allocVector (VECSXP, 3));
+    SET_VECTOR_ELT (out, 0, out_i);
+    SET_VECTOR_ELT (out, 1, out_j);
+    SET_VECTOR_ELT (out, 2, out_d);
+
+    SEXP nms = PROTECT (allocVector (STRSXP, 3));
+    SET_STRING_ELT (nms, 0, mkChar ("i"));
+    SET_STRING_ELT (nms, 1, mkChar ("j"));
+    SET_STRING_ELT (nms, 2, mkChar ("d"));
+    setAttrib (out, R_NamesSymbol, nms);
+
+    UNPROTECT (5);
+
+    return out;
+}
+
+//' All points in a kd-tree within a given distance of each point of (x, y)
+//' @return As for `within_search()`
+//' @noRd
+SEXP within_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, double radius, int upper, int nthreads)
+{
+    return within_search (t, NULL, NULL, x, y, nx, NULL, nx, radius, upper,
+            nthreads);
+}
+
+//' All points in a grid within a given distance of each point of p
+//'
+//' Points are searched in order of the cells of the grid in which they lie,
+//' so that consecutive searches mostly compare the same cells.
+//'
+//' @param upper If non-zero, p holds the same points as the grid.
+//' @return As for `within_search()`
+//' @noRd
+SEXP within_grid_search (const nn_grid *g, const point_tables *p,
+        double radius, int upper, int nthreads)
+{
+    size_t norder = g->p.n;
+    const size_t *order = upper ? g->index : nn_grid_order (g, p, &norder);
+
+    return within_search (NULL, g, p, NULL, NULL, p->n, order, norder,
+            radius, upper, nthreads);
+}
+
+//' k nearest neighbours in y of each point in x
+//'
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param k_ Number of nearest neighbours
+//' @return As for `knn_tree_search()`
+//' @noRd
+static SEXP xy_knn (SEXP x_, SEXP y_, SEXP k_, measure_t measure)
+{
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    size_t k = (size_t) Rf_asInteger (k_);
+
+    double *rx, *ry, cosy = 0.0;
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+
+    rx = REAL (x_);
+    ry = REAL (y_);
+    coords_validate (rx, rx + nx, nx);
+    coords_validate (ry, ry + ny, ny);
+
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    SEXP tree_ = PROTECT (nn_tree_create (ry, ry + ny, ny, measure, cosy));
+    SEXP out = knn_tree_search (nn_tree_get (tree_), rx, rx + nx, nx, k);
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' All pairs of points in x and y within a given distance
+//'
+//' @param r_ Maximal distance in metres
+//' @return As for `within_tree_search()`
+//' @noRd
+static SEXP xy_within (SEXP x_, SEXP y_, SEXP r_, measure_t measure)
+{
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    double radius = Rf_asReal (r_);
+
+    double *rx, *ry, cosy = 0.0;
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+
+    rx = REAL (x_);
+    ry = REAL (y_);
+    coords_validate (rx, rx + nx, nx);
+    coords_validate (ry, ry + ny, ny);
+
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    SEXP tree_ = PROTECT (nn_tree_create (ry, ry + ny, ny, measure, cosy));
+    SEXP out = within_tree_search (nn_tree_get (tree_), rx, rx + nx, nx,
+            radius, 0, 1);
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_haversine_knn
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param k_ Number of nearest neighbours
+//' @noRd
+SEXP R_haversine_knn (SEXP x_, SEXP y_, SEXP k_)
+{
+    return xy_knn (x_, y_, k_, MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_knn
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param k_ Number of nearest neighbours
+//' @noRd
+SEXP R_vincenty_knn (SEXP x_, SEXP y_, SEXP k_)
+{
+    return xy_knn (x_, y_, k_, MEASURE_VINCENTY);
+}
+
+//' R_cheap_knn
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param k_ Number of nearest neighbours
+//' @noRd
+SEXP R_cheap_knn (SEXP x_, SEXP y_, SEXP k_)
+{
+    return xy_knn (x_, y_, k_, MEASURE_CHEAP);
+}
+
+//' R_geodesic_knn
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param k_ Number of nearest neighbours
+//' @noRd
+SEXP R_geodesic_knn (SEXP x_, SEXP y_, SEXP k_)
+{
+    return xy_knn (x_, y_, k_, MEASURE_GEODESIC);
+}
+
+//' R_haversine_within
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_haversine_within (SEXP x_, SEXP y_, SEXP r_)
+{
+    return xy_within (x_, y_, r_, MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_within
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_vincenty_within (SEXP x_, SEXP y_, SEXP r_)
+{
+    return xy_within (x_, y_, r_, MEASURE_VINCENTY);
+}
+
+//' R_cheap_within
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_cheap_within (SEXP x_, SEXP y_, SEXP r_)
+{
+    return xy_within (x_, y_, r_, MEASURE_CHEAP);
+}
+
+//' R_geodesic_within
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_geodesic_within (SEXP x_, SEXP y_, SEXP r_)
+{
+    return xy_within (x_, y_, r_, MEASURE_GEODESIC);
+}
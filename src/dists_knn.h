@@ -0,0 +1,32 @@
+#ifndef DISTS_KNN_H
+#define DISTS_KNN_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stdio.h> 
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "grid.h"
+#include "threads.h"
+
+SEXP knn_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, size_t k);
+SEXP within_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, double radius, int upper, int nthreads);
+SEXP within_grid_search (const nn_grid *g, const point_tables *p,
+        double radius, int upper, int nthreads);
+
+SEXP R_haversine_knn (SEXP x_, SEXP y_, SEXP k_);
+SEXP R_vincenty_knn (SEXP x_, SEXP y_, SEXP k_);
+SEXP R_cheap_knn (SEXP x_, SEXP y_, SEXP k_);
+SEXP R_geodesic_knn (SEXP x_, SEXP y_, SEXP k_);
+
+SEXP R_haversine_within (SEXP x_, SEXP y_, SEXP r_);
+SEXP R_vincenty_within (SEXP x_, SEXP y_, SEXP r_);
+SEXP R_cheap_within (SEXP x_, SEXP y_, SEXP r_);
+SEXP R_geodesic_within (SEXP x_, SEXP y_, SEXP r_);
+
+#endif /* DISTS_KNN_H */
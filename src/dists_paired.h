@@ -8,10 +8,12 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "dists_paired_vec.h"
 
-SEXP R_haversine_paired (SEXP x_, SEXP y_);
-SEXP R_vincenty_paired (SEXP x_, SEXP y_);
-SEXP R_cheap_paired (SEXP x_, SEXP y_);
-SEXP R_geodesic_paired (SEXP x_, SEXP y_);
+SEXP R_haversine_paired (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_paired (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_paired (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_paired (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_paired (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* DISTS_PAIRED_H */
@@ -1,53 +1,27 @@
 #include "dists_paired_vec.h"
 
-//' R_haversine_paired_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' Paired distances between (x1, y1) and (x2, y2)
 //' @noRd
-SEXP R_haversine_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_)
+void paired_dists (measure_t measure, const double *rx1, const double *ry1,
+        const double *rx2, const double *ry2, size_t n, int nthreads,
+        double *rout)
 {
-    size_t n = (size_t) length (x1_);
-
-    double *rx1, *ry1, *rx2, *ry2, *rout;
-    double cosy1, cosy2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
-    y1_ = PROTECT (Rf_coerceVector (y1_, REALSXP));
-    x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
-    y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
+    point_tables p1, p2;
+    pair_tables_init (measure, rx1, ry1, n, &p1);
+    pair_tables_init (measure, rx2, ry2, n, &p2);
 
-    rx1 = REAL (x1_);
-    ry1 = REAL (y1_);
-    rx2 = REAL (x2_);
-    ry2 = REAL (y2_);
-    rout = REAL (out);
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (ry1, n, ry2, n);
 
-    for (size_t i = 0; i < n; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        cosy1 = cos (ry1 [i] * M_PI / 180.0); // y-value of x data
-        cosy2 = cos (ry2 [i] * M_PI / 180.0);
-        rout [i] = one_haversine (rx1 [i], ry1 [i], rx2 [i], ry2 [i],
-                cosy1, cosy2);
-    }
-
-    UNPROTECT (5);
-
-    return out;
+    kernel_paired_dists (measure, &p1, &p2, cosy, nthreads, rout);
 }
 
-//' R_vincenty_paired_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @noRd
-SEXP R_vincenty_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_)
+static SEXP paired_vec (measure_t measure, SEXP x1_, SEXP y1_,
+        SEXP x2_, SEXP y2_, SEXP threads_)
 {
     size_t n = (size_t) length (x1_);
-
-    double *rx1, *ry1, *rx2, *ry2, *rout;
-    double siny1, cosy1, siny2, cosy2;
+    int nthreads = get_num_threads (threads_);
 
     SEXP out = PROTECT (allocVector (REALSXP, n));
     x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
@@ -55,110 +29,60 @@ SEXP R_vincenty_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_)
     x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
     y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
 
-    rx1 = REAL (x1_);
-    ry1 = REAL (y1_);
-    rx2 = REAL (x2_);
-    ry2 = REAL (y2_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < n; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        siny1 = sin (ry1 [i] * M_PI / 180.0); // y-value of x data
-        cosy1 = cos (ry1 [i] * M_PI / 180.0); // y-value of x data
-        siny2 = sin (ry2 [i] * M_PI / 180.0);
-        cosy2 = cos (ry2 [i] * M_PI / 180.0);
-        rout [i] = one_vincenty (rx1 [i], rx2 [i],
-                siny1, cosy1, siny2, cosy2);
-    }
+    paired_dists (measure, REAL (x1_), REAL (y1_), REAL (x2_), REAL (y2_),
+            n, nthreads, REAL (out));
 
     UNPROTECT (5);
 
     return out;
 }
 
-//' R_cheap_paired_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' R_haversine_paired_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
 //' @noRd
-SEXP R_cheap_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_)
+SEXP R_haversine_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_)
 {
-    size_t n = (size_t) length (x1_);
-    double *rx1, *ry1, *rx2, *ry2, *rout;
-    double ymin = 9999.9, ymax = -9999.9;
-    double cosy;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
-    y1_ = PROTECT (Rf_coerceVector (y1_, REALSXP));
-    x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
-    y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
-
-    rx1 = REAL (x1_);
-    ry1 = REAL (y1_);
-    rx2 = REAL (x2_);
-    ry2 = REAL (y2_);
-    rout = REAL (out);
-
-    // Get maximal latitude range
-    for (size_t i = 0; i < n; i++)
-    {
-        if (ry1 [i] < ymin)
-            ymin = ry1 [i];
-        if (ry1 [i] > ymax)
-            ymax = ry1 [i];
-        if (ry2 [i] < ymin)
-            ymin = ry2 [i];
-        if (ry2 [i] > ymax)
-            ymax = ry2 [i];
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
-
-    for (size_t i = 0; i < n; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        rout [i] = one_cheap (rx1 [i], ry1 [i], rx2 [i], ry2 [i], cosy);
-    }
-
-    UNPROTECT (5);
+    return paired_vec (MEASURE_HAVERSINE, x1_, y1_, x2_, y2_, threads_);
+}
 
-    return out;
+//' R_vincenty_paired_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
+//' @noRd
+SEXP R_vincenty_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_)
+{
+    return paired_vec (MEASURE_VINCENTY, x1_, y1_, x2_, y2_, threads_);
 }
 
+//' R_cheap_paired_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
+//' @noRd
+SEXP R_cheap_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_)
+{
+    return paired_vec (MEASURE_CHEAP, x1_, y1_, x2_, y2_, threads_);
+}
 
 //' R_geodesic_paired_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
 //' @noRd
-SEXP R_geodesic_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_)
+SEXP R_geodesic_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_)
 {
-    size_t n = (size_t) length (x1_);
-    double *rx1, *ry1, *rx2, *ry2, *rout;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x1_ = PROTECT (Rf_coerceVector (x1_, REALSXP));
-    y1_ = PROTECT (Rf_coerceVector (y1_, REALSXP));
-    x2_ = PROTECT (Rf_coerceVector (x2_, REALSXP));
-    y2_ = PROTECT (Rf_coerceVector (y2_, REALSXP));
-
-    rx1 = REAL (x1_);
-    ry1 = REAL (y1_);
-    rx2 = REAL (x2_);
-    ry2 = REAL (y2_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < n; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        rout [i] = one_geodesic (rx1 [i], ry1 [i], rx2 [i], ry2 [i]);
-    }
-
-    UNPROTECT (5);
+    return paired_vec (MEASURE_GEODESIC, x1_, y1_, x2_, y2_, threads_);
+}
 
-    return out;
+//' R_ruler_paired_vec
+//' @param x1_, y1_ Vectors of x- and y-values
+//' @param x2_, y2_ Additional vectors of x- and y-values
+//' @noRd
+SEXP R_ruler_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_)
+{
+    return paired_vec (MEASURE_RULER, x1_, y1_, x2_, y2_, threads_);
 }
@@ -8,10 +8,22 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "kernels.h"
+#include "threads.h"
 
-SEXP R_haversine_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_vincenty_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_cheap_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_geodesic_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
+void paired_dists (measure_t measure, const double *rx1, const double *ry1,
+        const double *rx2, const double *ry2, size_t n, int nthreads,
+        double *rout);
+
+SEXP R_haversine_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_vincenty_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_cheap_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_geodesic_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_ruler_paired_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
 
 #endif /* DISTS_PAIRED_VEC_H */
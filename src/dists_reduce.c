@@ -0,0 +1,282 @@
+#include "dists_reduce.h"
+
+// Points and per-point tables of one distance matrix. If 'symmetric', then p2
+// is p1, and each distance is calculated with the lower index first, exactly
+// as for the upper triangle of the full matrix.
+typedef struct
+{
+    point_tables p1, p2;
+    double cosy;
+    measure_t measure;
+    int simd, symmetric;
+} reduce_ctx;
+
+// Running value of one reduction
+typedef struct
+{
+    double res;
+    size_t jres;
+    int found;
+} reduce_acc;
+
+//' Add n distances of indices [j0, j0 + n) to a reduction
+//'
+//' Missing distances are ignored.
+//' @noRd
+static void reduce_add (reduce_acc *a, const double *d, size_t j0, size_t n,
+        reduce_t fun, double threshold)
+{
+    for (size_t j = 0; j < n; j++)
+    {
+        if (ISNAN (d [j]))
+            continue;
+
+        switch (fun)
+        {
+            case REDUCE_MIN:
+            case REDUCE_ARGMIN:
+                if (!a->found || d [j] < a->res)
+                {
+                    a->res = d [j];
+                    a->jres = j0 + j;
+                }
+                break;
+            case REDUCE_MAX:
+                if (!a->found || d [j] > a->res)
+                    a->res = d [j];
+                break;
+            case REDUCE_SUM:
+                a->res += d [j];
+                break;
+            case REDUCE_COUNT_LT:
+                if (d [j] < threshold)
+                    a->res += 1.0;
+                break;
+        }
+        a->found = 1;
+    }
+}
+
+//' Reduce one tile of rows (margin = 1) or columns (margin = 2) of a
+//' distance matrix
+//'
+//' All distances are calculated with the row kernels of full matrices, so
+//' that they are identical to those of `geodist()`, including those of batch
+//' kernels. Columns, and the lower triangles of symmetric rows, are reduced
+//' from rows of p1 across all columns [k0, k0 + nk) of the tile at once, and
+//' the remaining rows in segments of TILE_NY points, so that distances are
+//' always added in order of index. If there are no distances which are not
+//' missing, then minima, maxima, and their indices are NA.
+//'
+//' @param nk No greater than TILE_NY.
+//' @param buf Scratch space for TILE_NY distances.
+//' @param acc Scratch space for TILE_NY reductions.
+//' @noRd
+static void reduce_tile (const reduce_ctx *c, size_t k0, size_t nk,
+        int margin, reduce_t fun, double threshold, double *buf,
+        reduce_acc *acc, double *rout, int *iout)
+{
+    for (size_t k = 0; k < nk; k++)
+    {
+        acc [k].res = 0.0;
+        acc [k].jres = 0;
+        acc [k].found = 0;
+    }
+
+    // Distances from points j of p1 to points k of the tile, excluding the
+    // diagonal and above of symmetric matrices:
+    size_t nj = (margin == 2) ? c->p1.n : (c->symmetric ? k0 + nk : 0);
+    for (size_t j = 0; j < nj; j++)
+    {
+        size_t kstart = (c->symmetric && j >= k0) ? j + 1 - k0 : 0;
+        if (kstart >= nk)
+            continue;
+        kernel_row (c->measure, &c->p1, j, &c->p2, k0 + kstart,
+                nk - kstart, c->cosy, c->simd, buf);
+        for (size_t k = kstart; k < nk; k++)
+            reduce_add (acc + k, buf + k - kstart, j, 1, fun, threshold);
+    }
+
+    // Distances from points k of the tile to points j of p2, from the
+    // diagonal onwards for symmetric matrices:
+    size_t nrows = (margin == 1) ? nk : 0;
+    for (size_t k = 0; k < nrows; k++)
+    {
+        size_t n = c->p2.n, j0 = 0;
+        if (c->symmetric)
+        {
+            double d = 0.0;
+            reduce_add (acc + k, &d, k0 + k, 1, fun, threshold);
+            j0 = k0 + k + 1;
+        }
+        for (; j0 < n; j0 += TILE_NY)
+        {
+            size_t n0 = (n - j0 < TILE_NY) ? n - j0 : TILE_NY;
+            kernel_row (c->measure, &c->p1, k0 + k, &c->p2, j0, n0, c->cosy,
+                    c->simd, buf);
+            reduce_add (acc + k, buf, j0, n0, fun, threshold);
+        }
+    }
+
+    for (size_t k = 0; k < nk; k++)
+    {
+        const reduce_acc *a = acc + k;
+        if (fun == REDUCE_ARGMIN)
+            iout [k0 + k] = a->found ? (int) a->jres + 1L : NA_INTEGER;
+        else if (fun == REDUCE_COUNT_LT)
+            iout [k0 + k] = (int) a->res;
+        else if (!a->found && (fun == REDUCE_MIN || fun == REDUCE_MAX))
+            rout [k0 + k] = NA_REAL;
+        else
+            rout [k0 + k] = a->res;
+    }
+}
+
+//' Reductions over all rows or columns of a distance matrix
+//'
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)], or
+//' NULL to reduce the symmetric distance matrix of x.
+//' @param fun_ Integer-valued 'reduce_t'.
+//' @param margin_ 1 to reduce over each row of x, or 2 for each row of y.
+//' @param threshold_ Distance for REDUCE_COUNT_LT.
+//' @return Vector of one value for each row or column; integer for argmin and
+//' count reductions, otherwise double.
+//' @noRd
+static SEXP xy_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_, measure_t measure)
+{
+    reduce_t fun = (reduce_t) Rf_asInteger (fun_);
+    int margin = Rf_asInteger (margin_);
+    double threshold = Rf_asReal (threshold_);
+    int nthreads = get_num_threads (threads_);
+    int symmetric = Rf_isNull (y_);
+    int nprot = 1;
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    if (!symmetric)
+    {
+        y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+        nprot++;
+    } else
+    {
+        y_ = x_;
+        margin = 1;
+    }
+
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    const double *rx = REAL (x_), *ry = REAL (y_);
+
+    reduce_ctx c;
+    point_tables_init (measure, rx, rx + nx, nx, &c.p1);
+    if (symmetric)
+        c.p2 = c.p1;
+    else
+        point_tables_init (measure, ry, ry + ny, ny, &c.p2);
+    c.cosy = (measure == MEASURE_CHEAP) ?
+        cheap_cosy (rx + nx, nx, ry + ny, symmetric ? 0 : ny) : 0.0;
+    c.measure = measure;
+    c.simd = batch_enabled ();
+    c.symmetric = symmetric;
+
+    int use_int = (fun == REDUCE_ARGMIN || fun == REDUCE_COUNT_LT);
+    size_t nout = (margin == 1) ? nx : ny;
+    SEXP out = PROTECT (allocVector (use_int ? INTSXP : REALSXP, nout));
+    nprot++;
+    int *iout = use_int ? INTEGER (out) : NULL;
+    double *rout = use_int ? NULL : REAL (out);
+
+    double *scratch = (double *) stats_alloc ((size_t) nthreads * TILE_NY,
+            sizeof (double));
+    reduce_acc *accs = (reduce_acc *) stats_alloc ((size_t) nthreads * TILE_NY,
+            sizeof (reduce_acc));
+    size_t nblocks;
+    size_t *blocks = row_blocks (nout, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        double *buf = scratch + omp_get_thread_num () * TILE_NY;
+        reduce_acc *acc = accs + omp_get_thread_num () * TILE_NY;
+        for (size_t k0 = blocks [b]; k0 < blocks [b + 1]; k0 += TILE_NY)
+        {
+            size_t nk = blocks [b + 1] - k0;
+            if (nk > TILE_NY)
+                nk = TILE_NY;
+            reduce_tile (&c, k0, nk, margin, fun, threshold, buf, acc, rout,
+                    iout);
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    UNPROTECT (nprot);
+
+    return out;
+}
+
+//' R_haversine_reduce
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_haversine_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_)
+{
+    return xy_reduce (x_, y_, fun_, margin_, threshold_, threads_,
+            MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_reduce
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_vincenty_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_)
+{
+    return xy_reduce (x_, y_, fun_, margin_, threshold_, threads_,
+            MEASURE_VINCENTY);
+}
+
+//' R_cheap_reduce
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_cheap_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_)
+{
+    return xy_reduce (x_, y_, fun_, margin_, threshold_, threads_,
+            MEASURE_CHEAP);
+}
+
+//' R_geodesic_reduce
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_geodesic_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_)
+{
+    return xy_reduce (x_, y_, fun_, margin_, threshold_, threads_,
+            MEASURE_GEODESIC);
+}
+
+//' R_ruler_reduce
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_ruler_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_)
+{
+    return xy_reduce (x_, y_, fun_, margin_, threshold_, threads_,
+            MEASURE_RULER);
+}
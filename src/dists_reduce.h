@@ -0,0 +1,35 @@
+#ifndef DISTS_REDUCE_H
+#define DISTS_REDUCE_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "tiles.h"
+#include "kernels.h"
+
+// Reductions of rows or columns of distance matrices, with values matching
+// the 'fun' argument of 'geodist_reduce()'
+typedef enum
+{
+    REDUCE_MIN,
+    REDUCE_ARGMIN,
+    REDUCE_MAX,
+    REDUCE_SUM,
+    REDUCE_COUNT_LT
+} reduce_t;
+
+SEXP R_haversine_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_);
+SEXP R_vincenty_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_);
+SEXP R_cheap_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_);
+SEXP R_geodesic_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_);
+SEXP R_ruler_reduce (SEXP x_, SEXP y_, SEXP fun_, SEXP margin_,
+        SEXP threshold_, SEXP threads_);
+
+#endif /* DISTS_REDUCE_H */
@@ -6,10 +6,12 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "dists_seq_vec.h"
 
-SEXP R_haversine_seq (SEXP x_);
-SEXP R_vincenty_seq (SEXP x_);
-SEXP R_cheap_seq (SEXP x_);
-SEXP R_geodesic_seq (SEXP x_);
+SEXP R_haversine_seq (SEXP x_, SEXP threads_);
+SEXP R_vincenty_seq (SEXP x_, SEXP threads_);
+SEXP R_cheap_seq (SEXP x_, SEXP threads_);
+SEXP R_geodesic_seq (SEXP x_, SEXP threads_);
+SEXP R_ruler_seq (SEXP x_, SEXP threads_);
 
 #endif /* DISTS_SEQ_H */
@@ -0,0 +1,177 @@
+#include "dists_seq_groups.h"
+
+//' Sequential cheap distances within each group
+//'
+//' Each group has its own constant cosine multiplier, as for sequential
+//' distances of that group alone. Groups are processed in blocks distributed
+//' dynamically across threads.
+//'
+//' @param p1, p2 Point tables of all points, and of all but the first, so that
+//' pair i of p1 and p2 is the step to point i + 1.
+//' @noRd
+static void seq_groups_cheap (const point_tables *p1, const point_tables *p2,
+        const size_t *starts, size_t ngroups, int nthreads, double *rout)
+{
+    int simd = batch_enabled ();
+
+    double *cosy = (double *) stats_alloc (ngroups, sizeof (double));
+    for (size_t g = 0; g < ngroups; g++)
+        cosy [g] = cheap_cosy (p1->y + starts [g],
+                starts [g + 1] - starts [g], NULL, 0);
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (ngroups, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t g = blocks [b]; g < blocks [b + 1]; g++)
+        {
+            size_t i0 = starts [g], ng = starts [g + 1] - starts [g];
+            if (ng < 2)
+                continue;
+            pairs_cheap (p1, p2, i0, ng - 1, cosy [g], simd, rout + i0 + 1);
+            na_mask_pairs (p1, p2, i0, ng - 1, rout + i0 + 1);
+        }
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Sequential distances along (x, y), restarting at each group
+//'
+//' Distances for all measures other than cheap do not depend on any other
+//' points, and so are calculated as paired distances along the entire
+//' sequence, balanced across threads by points rather than by groups, with the
+//' distances between the last point of one group and the first of the next
+//' then replaced with NA. Coordinates of all measures are validated once
+//' only, with NA distances to and from missing points.
+//'
+//' @param starts Vector of (ngroups + 1) offsets, with group g spanning
+//' [starts[g], starts[g + 1]).
+//' @param rout Vector of length starts[ngroups] filled with distances, with
+//' NA for the first point of each group.
+//' @noRd
+static void seq_groups_dists (measure_t measure, const double *rx,
+        const double *ry, const size_t *starts, size_t ngroups,
+        int nthreads, double *rout)
+{
+    size_t n = starts [ngroups];
+
+    if (n == 0)
+        return;
+
+    point_tables p1, p2;
+    pair_tables_init (measure, rx, ry, n, &p1);
+    point_tables_shift (&p1, 1, &p2);
+
+    if (measure == MEASURE_CHEAP)
+        seq_groups_cheap (&p1, &p2, starts, ngroups, nthreads, rout);
+    else
+        kernel_paired_dists (measure, &p1, &p2, 0.0, nthreads, rout + 1);
+
+    for (size_t g = 0; g < ngroups; g++)
+        if (starts [g] < n)
+            rout [starts [g]] = NA_REAL;
+}
+
+static SEXP seq_groups (measure_t measure, SEXP x_, SEXP y_, SEXP starts_,
+        SEXP totals_, SEXP threads_)
+{
+    int nthreads = get_num_threads (threads_);
+    size_t ngroups = (size_t) length (starts_) - 1;
+    size_t n;
+    double *rx, *ry;
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    if (isNull (y_))
+    {
+        n = (size_t) (floor (length (x_) / 2));
+        rx = REAL (x_);
+        ry = rx + n;
+        y_ = PROTECT (y_);
+    } else
+    {
+        n = (size_t) length (x_);
+        y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+        rx = REAL (x_);
+        ry = REAL (y_);
+    }
+    starts_ = PROTECT (Rf_coerceVector (starts_, REALSXP));
+
+    size_t *starts = (size_t *) stats_alloc (ngroups + 1, sizeof (size_t));
+    for (size_t g = 0; g <= ngroups; g++)
+        starts [g] = (size_t) REAL (starts_) [g];
+    if (starts [ngroups] != n)
+        Rf_error ("group offsets do not match number of points");
+
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+    double *rout = REAL (out);
+    seq_groups_dists (measure, rx, ry, starts, ngroups, nthreads, rout);
+
+    if (asLogical (totals_))
+    {
+        SEXP tot = PROTECT (allocVector (REALSXP, ngroups));
+        for (size_t g = 0; g < ngroups; g++)
+        {
+            double d = 0.0;
+            for (size_t i = starts [g] + 1; i < starts [g + 1]; i++)
+                if (!ISNAN (rout [i]))
+                    d += rout [i];
+            REAL (tot) [g] = d;
+        }
+        UNPROTECT (5);
+        return tot;
+    }
+
+    UNPROTECT (4);
+
+    return out;
+}
+
+//' R_haversine_seq_groups
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)] if
+//' y_ is NULL, otherwise vector of x-values
+//' @param y_ Vector of y-values, or NULL
+//' @param starts_ Offsets of the first point of each group, followed by the
+//' total number of points
+//' @param totals_ If TRUE, return the total distance along each group,
+//' otherwise all distances.
+//' @noRd
+SEXP R_haversine_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_)
+{
+    return seq_groups (MEASURE_HAVERSINE, x_, y_, starts_, totals_, threads_);
+}
+
+//' R_vincenty_seq_groups
+//' @param x_, y_, starts_, totals_ As for `R_haversine_seq_groups`
+//' @noRd
+SEXP R_vincenty_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_)
+{
+    return seq_groups (MEASURE_VINCENTY, x_, y_, starts_, totals_, threads_);
+}
+
+//' R_cheap_seq_groups
+//' @param x_, y_, starts_, totals_ As for `R_haversine_seq_groups`
+//' @noRd
+SEXP R_cheap_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_)
+{
+    return seq_groups (MEASURE_CHEAP, x_, y_, starts_, totals_, threads_);
+}
+
+//' R_geodesic_seq_groups
+//' @param x_, y_, starts_, totals_ As for `R_haversine_seq_groups`
+//' @noRd
+SEXP R_geodesic_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_)
+{
+    return seq_groups (MEASURE_GEODESIC, x_, y_, starts_, totals_, threads_);
+}
@@ -0,0 +1,22 @@
+#ifndef DISTS_SEQ_GROUPS_H
+#define DISTS_SEQ_GROUPS_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "batch.h"
+#include "kernels.h"
+#include "dists_paired_vec.h"
+
+SEXP R_haversine_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_);
+SEXP R_vincenty_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_);
+SEXP R_cheap_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_);
+SEXP R_geodesic_seq_groups (SEXP x_, SEXP y_, SEXP starts_, SEXP totals_,
+        SEXP threads_);
+
+#endif /* DISTS_SEQ_GROUPS_H */
@@ -0,0 +1,187 @@
+#include "dists_seq_stream.h"
+
+static void seq_stream_finalizer (SEXP stream_)
+{
+    seq_stream *s = (seq_stream *) R_ExternalPtrAddr (stream_);
+    if (s)
+    {
+        free (s);
+        R_ClearExternalPtr (stream_);
+    }
+}
+
+//' Create an empty sequential distance stream
+//' @return External pointer to a `seq_stream`, freed on garbage collection.
+//' @noRd
+static SEXP seq_stream_create (measure_t measure)
+{
+    seq_stream *s = (seq_stream *) calloc (1, sizeof (seq_stream));
+    if (!s)
+        Rf_error ("Unable to allocate stream"); // # nocov
+
+    SEXP stream_ = PROTECT (R_MakeExternalPtr (s,
+                Rf_install ("geodist_stream"), R_NilValue));
+    R_RegisterCFinalizerEx (stream_, seq_stream_finalizer, TRUE);
+
+    s->measure = measure;
+    s->min = NA_REAL;
+    s->max = NA_REAL;
+
+    UNPROTECT (1);
+
+    return stream_;
+}
+
+static seq_stream * seq_stream_get (SEXP stream_)
+{
+    if (TYPEOF (stream_) != EXTPTRSXP ||
+            R_ExternalPtrTag (stream_) != Rf_install ("geodist_stream"))
+        Rf_error ("stream must be a 'geodist_stream' object");
+    seq_stream *s = (seq_stream *) R_ExternalPtrAddr (stream_);
+    if (!s)
+        Rf_error ("stream is no longer valid, and must be re-created");
+    return s;
+}
+
+//' Distance between the last point of the previous chunk and (x, y)
+//'
+//' Calculated with the same paired kernel as all other segments, from the
+//' tables of those two points alone, so that distances of streams are
+//' identical to those of the whole sequence, with NA for missing points.
+//' @noRd
+static double seq_stream_first (const seq_stream *s, double x, double y)
+{
+    double xs [2] = { s->x, x }, ys [2] = { s->y, y }, d;
+
+    point_tables p1, p2;
+    pair_tables_init (s->measure, xs, ys, 2, &p1);
+    point_tables_shift (&p1, 1, &p2);
+    kernel_paired_dists (s->measure, &p1, &p2, s->cosy, 1, &d);
+
+    return d;
+}
+
+//' Append one chunk of points to a stream
+//'
+//' The first segment joins the last point of the previous chunk to the first
+//' point of this chunk, and all others are the paired distances of the chunk
+//' offset by one, as in `seq_dists()`. The cheap multiplier is fixed by the
+//' latitudes of the first chunk.
+//'
+//' @param rout Vector of length n filled with distances, the first of which
+//' is NA for the first chunk of a stream.
+//' @noRd
+static void seq_stream_append (seq_stream *s, const double *rx,
+        const double *ry, size_t n, int nthreads, double *rout)
+{
+    if (n == 0)
+        return;
+
+    point_tables p1, p2;
+    pair_tables_init (s->measure, rx, ry, n, &p1);
+    point_tables_shift (&p1, 1, &p2);
+    if (s->measure == MEASURE_CHEAP && s->n == 0)
+        s->cosy = cheap_cosy (ry, n, NULL, 0);
+
+    rout [0] = (s->n > 0) ? seq_stream_first (s, rx [0], ry [0]) : NA_REAL;
+    kernel_paired_dists (s->measure, &p1, &p2, s->cosy, nthreads, rout + 1);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double d = rout [i];
+        if (ISNAN (d))
+            continue;
+        s->length += d;
+        if (s->nseg == 0 || d < s->min)
+            s->min = d;
+        if (s->nseg == 0 || d > s->max)
+            s->max = d;
+        s->nseg++;
+    }
+
+    s->x = rx [n - 1];
+    s->y = ry [n - 1];
+    s->n += n;
+}
+
+//' R_haversine_seq_stream
+//' @noRd
+SEXP R_haversine_seq_stream (void)
+{
+    return seq_stream_create (MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_seq_stream
+//' @noRd
+SEXP R_vincenty_seq_stream (void)
+{
+    return seq_stream_create (MEASURE_VINCENTY);
+}
+
+//' R_cheap_seq_stream
+//' @noRd
+SEXP R_cheap_seq_stream (void)
+{
+    return seq_stream_create (MEASURE_CHEAP);
+}
+
+//' R_geodesic_seq_stream
+//' @noRd
+SEXP R_geodesic_seq_stream (void)
+{
+    return seq_stream_create (MEASURE_GEODESIC);
+}
+
+//' R_seq_stream_append
+//' @param stream_ External pointer to a `seq_stream`
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param segments_ If TRUE, return the distances of all segments ending at
+//' each point of x_, otherwise return NULL.
+//' @noRd
+SEXP R_seq_stream_append (SEXP stream_, SEXP x_, SEXP segments_,
+        SEXP threads_)
+{
+    seq_stream *s = seq_stream_get (stream_);
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    SEXP out = PROTECT (allocVector (REALSXP, n));
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+
+    double *rx = REAL (x_);
+    seq_stream_append (s, rx, rx + n, n, nthreads, REAL (out));
+
+    UNPROTECT (2);
+
+    if (!asLogical (segments_))
+        return R_NilValue;
+
+    return out;
+}
+
+//' R_seq_stream_stats
+//' @param stream_ External pointer to a `seq_stream`
+//' @return Vector of numbers of points and non-missing segments, and the total
+//' length, and minimal and maximal distances of those segments.
+//' @noRd
+SEXP R_seq_stream_stats (SEXP stream_)
+{
+    seq_stream *s = seq_stream_get (stream_);
+
+    SEXP out = PROTECT (allocVector (REALSXP, 5));
+    SEXP nms = PROTECT (allocVector (STRSXP, 5));
+    const char *names [5] = {"n", "segments", "length", "min", "max"};
+    for (int i = 0; i < 5; i++)
+        SET_STRING_ELT (nms, i, mkChar (names [i]));
+
+    REAL (out) [0] = (double) s->n;
+    REAL (out) [1] = (double) s->nseg;
+    REAL (out) [2] = s->length;
+    REAL (out) [3] = s->min;
+    REAL (out) [4] = s->max;
+    setAttrib (out, R_NamesSymbol, nms);
+
+    UNPROTECT (2);
+
+    return out;
+}
@@ -0,0 +1,34 @@
+#ifndef DISTS_SEQ_STREAM_H
+#define DISTS_SEQ_STREAM_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <math.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "dists_paired_vec.h"
+
+// State of sequential distances along a track passed in successive chunks,
+// carrying the last point and running statistics from one chunk to the next.
+typedef struct
+{
+    measure_t measure;
+    double cosy; // constant cosine multiplier for cheap distances
+    double x, y; // last point of previous chunk
+    size_t n; // number of points
+    size_t nseg; // number of non-missing segments
+    double length, min, max;
+} seq_stream;
+
+SEXP R_haversine_seq_stream (void);
+SEXP R_vincenty_seq_stream (void);
+SEXP R_cheap_seq_stream (void);
+SEXP R_geodesic_seq_stream (void);
+
+SEXP R_seq_stream_append (SEXP stream_, SEXP x_, SEXP segments_,
+        SEXP threads_);
+SEXP R_seq_stream_stats (SEXP stream_);
+
+#endif /* DISTS_SEQ_STREAM_H */
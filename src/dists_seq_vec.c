@@ -1,136 +1,83 @@
 #include "dists_seq_vec.h"
 
-//' R_haversine_seq_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' Sequential distances along (x, y)
+//'
+//' Distances between successive points are paired distances between the
+//' points offset by one, with trigonometric tables calculated only once.
+//'
+//' @param rout Vector of length n filled with distances, the first of which
+//' is NA.
 //' @noRd
-SEXP R_haversine_seq_vec (SEXP x_, SEXP y_)
+void seq_dists (measure_t measure, const double *rx, const double *ry,
+        size_t n, int nthreads, double *rout)
 {
-    size_t n = (size_t) length (x_);
-    double *rx, *ry, *rout;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
+    if (n == 0)
+        return;
     rout [0] = NA_REAL;
-    for (size_t i = 1; i < n; i++)
-    {
-        rout [i] = one_haversine (rx [i - 1], ry [i - 1],
-                rx [i], ry [i],
-                cos (ry [i] * M_PI / 180.0),
-                cos (ry [i - 1] * M_PI / 180.0));
-    }
 
-    UNPROTECT (2);
+    point_tables p1, p2;
+    pair_tables_init (measure, rx, ry, n, &p1);
+    point_tables_shift (&p1, 1, &p2);
 
-    return out;
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (ry, n, NULL, 0);
+
+    kernel_paired_dists (measure, &p1, &p2, cosy, nthreads, rout + 1);
 }
 
-//' R_vincenty_seq_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @noRd
-SEXP R_vincenty_seq_vec (SEXP x_, SEXP y_)
+static SEXP seq_vec (measure_t measure, SEXP x_, SEXP y_, SEXP threads_)
 {
     size_t n = (size_t) length (x_);
-    double *rx, *ry, *rout;
-    double siny1, cosy1, siny2, cosy2;
+    int nthreads = get_num_threads (threads_);
 
     SEXP out = PROTECT (allocVector (REALSXP, n));
     x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
 
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    rout [0] = NA_REAL;
-
-    for (size_t i = 1; i < n; i++)
-    {
-        siny1 = sin (ry [i - 1] * M_PI / 180.0);
-        cosy1 = cos (ry [i - 1] * M_PI / 180.0);
-        siny2 = sin (ry [i] * M_PI / 180.0);
-        cosy2 = cos (ry [i] * M_PI / 180.0);
-        rout [i] = one_vincenty (rx [i - 1], rx [i],
-                siny1, cosy1, siny2, cosy2);
-    }
+    seq_dists (measure, REAL (x_), REAL (y_), n, nthreads, REAL (out));
 
-    UNPROTECT (2);
+    UNPROTECT (3);
 
     return out;
 }
 
-//' R_cheap_seq_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' R_haversine_seq_vec
+//' @param x_, y_ Vectors of x- and y-values
 //' @noRd
-SEXP R_cheap_seq_vec (SEXP x_, SEXP y_)
+SEXP R_haversine_seq_vec (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t n = (size_t) length (x_);
-    double *rx, *ry, *rout;
-    double ymin = 9999.9, ymax = -9999.9;
-    double cosy;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    // Get maximal latitude range
-    for (size_t i = 0; i < n; i++)
-    {
-        if (ry [i] < ymin)
-            ymin = ry [i];
-        if (ry [i] > ymax)
-            ymax = ry [i];
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
-
-    rout [0] = NA_REAL;
-
-    for (size_t i = 1; i < n; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        rout [i] = one_cheap (rx [i - 1], ry [i - 1],
-                rx [i], ry [i], cosy);
-    }
+    return seq_vec (MEASURE_HAVERSINE, x_, y_, threads_);
+}
 
-    UNPROTECT (2);
+//' R_vincenty_seq_vec
+//' @param x_, y_ Vectors of x- and y-values
+//' @noRd
+SEXP R_vincenty_seq_vec (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return seq_vec (MEASURE_VINCENTY, x_, y_, threads_);
+}
 
-    return out;
+//' R_cheap_seq_vec
+//' @param x_, y_ Vectors of x- and y-values
+//' @noRd
+SEXP R_cheap_seq_vec (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return seq_vec (MEASURE_CHEAP, x_, y_, threads_);
 }
 
 //' R_geodesic_seq_vec
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param x_, y_ Vectors of x- and y-values
 //' @noRd
-SEXP R_geodesic_seq_vec (SEXP x_, SEXP y_)
+SEXP R_geodesic_seq_vec (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t n = (size_t) length (x_);
-    double *rx, *ry, *rout;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    rout [0] = NA_REAL;
-
-    for (size_t i = 1; i < n; i++)
-    {
-        rout [i] = one_geodesic (rx [i - 1], ry [i - 1],
-                rx [i], ry [i]);
-    }
-
-    UNPROTECT (2);
+    return seq_vec (MEASURE_GEODESIC, x_, y_, threads_);
+}
 
-    return out;
+//' R_ruler_seq_vec
+//' @param x_, y_ Vectors of x- and y-values
+//' @noRd
+SEXP R_ruler_seq_vec (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return seq_vec (MEASURE_RULER, x_, y_, threads_);
 }
@@ -6,10 +6,15 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "dists_paired_vec.h"
 
-SEXP R_haversine_seq_vec (SEXP x_, SEXP y_);
-SEXP R_vincenty_seq_vec (SEXP x_, SEXP y_);
-SEXP R_cheap_seq_vec (SEXP x_, SEXP y_);
-SEXP R_geodesic_seq_vec (SEXP x_, SEXP y_);
+void seq_dists (measure_t measure, const double *rx, const double *ry,
+        size_t n, int nthreads, double *rout);
+
+SEXP R_haversine_seq_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_seq_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_seq_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_seq_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_seq_vec (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* DISTS_SEQ_VEC_H */
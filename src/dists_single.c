@@ -0,0 +1,184 @@
+#include "dists_single.h"
+
+// Single-precision distances, returned as integer centimetres. Differences
+// in coordinates are calculated in double precision, because single-precision
+// longitudes near the antimeridian are only resolved to around 1m, with all
+// subsequent calculations in single precision. Integer centimetres cover the
+// maximal great-circle distance between any two points of around 20,037km,
+// and take half the memory of double-precision metres. Larger distances, which
+// are only possible with cheap distances, are returned as NA.
+
+static int dist_to_cm (float d)
+{
+    double cm = (double) d * 100.0;
+    if (!isfinite (cm) || cm > (double) INT_MAX)
+        return NA_INTEGER;
+    return (int) lround (cm);
+}
+
+// Single-precision counterparts of the pair kernels of kernels.h, reading
+// coordinates from the same point tables, and cosines of latitudes from
+// single-precision tables of `cos_table_f()`.
+static inline float pair_haversine_f (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, const float *cosy1,
+        const float *cosy2)
+{
+    float sxd = sinf ((float) ((p2->x [j] - p1->x [i]) * M_PI / 360.0));
+    float syd = sinf ((float) ((p2->y [j] - p1->y [i]) * M_PI / 360.0));
+    float d = syd * syd + cosy1 [i] * cosy2 [j] * sxd * sxd;
+    return 2.0f * (float) earth * asinf (sqrtf (d));
+}
+
+static inline float pair_cheap_f (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, float cosy)
+{
+    float dy = (float) (p1->y [i] - p2->y [j]) * (float) (meridian / 180.0);
+    float dx = (float) (p1->x [i] - p2->x [j]) * cosy *
+        (float) (equator / 360.0);
+    return sqrtf (dx * dx + dy * dy);
+}
+
+//' Single-precision cosines of latitudes
+//' @noRd
+static float * cos_table_f (const double *y, size_t n)
+{
+    float *c = (float *) stats_alloc (n, sizeof (float));
+    for (size_t i = 0; i < n; i++)
+        c [i] = (float) cos (y [i] * M_PI / 180.0);
+    return c;
+}
+
+//' Single-precision distances between point i of p1 and points [j0, ny) of
+//' p2, with NA for missing points, as for `kernel_row()`
+//' @noRd
+static void row_single (measure_t measure, const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, const float *cosy1,
+        const float *cosy2, float cosy, int *row)
+{
+    size_t ny = p2->n;
+
+    if (point_na (p1, i))
+    {
+        for (size_t j = j0; j < ny; j++)
+            row [j] = NA_INTEGER;
+        return;
+    }
+
+    if (measure == MEASURE_HAVERSINE)
+    {
+        for (size_t j = j0; j < ny; j++)
+            row [j] = dist_to_cm (pair_haversine_f (p1, i, p2, j, cosy1,
+                        cosy2));
+    } else
+    {
+        for (size_t j = j0; j < ny; j++)
+            row [j] = dist_to_cm (pair_cheap_f (p1, i, p2, j, cosy));
+    }
+
+    if (p2->na != NULL)
+        for (size_t j = j0; j < ny; j++)
+            if (p2->na [j])
+                row [j] = NA_INTEGER;
+}
+
+//' Single-precision distance matrices
+//'
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)], or
+//' NULL for the symmetric distance matrix of x.
+//' @return Integer vector of distances in centimetres, in the same order as
+//' the corresponding double-precision kernels.
+//' @noRd
+static SEXP single_dists (SEXP x_, SEXP y_, SEXP threads_, measure_t measure)
+{
+    int nthreads = get_num_threads (threads_);
+    int symmetric = Rf_isNull (y_);
+    int nprot = 2;
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    if (symmetric)
+    {
+        y_ = x_;
+        nprot--;
+    } else
+        y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t ny = (size_t) (floor (length (y_) / 2));
+    const double *rx = REAL (x_), *ry = REAL (y_);
+
+    // Only coordinates and masks of missing points are taken from the point
+    // tables, with no double-precision terms:
+    point_tables p1, p2;
+    point_tables_init (MEASURE_CHEAP, rx, rx + nx, nx, &p1);
+    if (symmetric)
+        p2 = p1;
+    else
+        point_tables_init (MEASURE_CHEAP, ry, ry + ny, ny, &p2);
+
+    SEXP out = PROTECT (allocVector (INTSXP, nx * ny));
+    nprot++;
+    int *iout = INTEGER (out);
+
+    float *cosy1 = NULL, *cosy2 = NULL, cosy = 0.0f;
+    if (measure == MEASURE_HAVERSINE)
+    {
+        cosy1 = cos_table_f (rx + nx, nx);
+        cosy2 = symmetric ? cosy1 : cos_table_f (ry + ny, ny);
+    } else
+        cosy = (float) cheap_cosy (rx + nx, nx, ry + ny, symmetric ? 0 : ny);
+
+    size_t nblocks;
+    size_t *blocks = symmetric ?
+        tri_row_blocks (nx, nthreads, &nblocks) :
+        row_blocks (nx, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+    if (symmetric)
+        for (size_t i = 0; i < nx; i++)
+            iout [i * nx + i] = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            size_t j0 = symmetric ? i + 1 : 0;
+            int *row = iout + i * ny;
+            row_single (measure, &p1, i, &p2, j0, cosy1, cosy2, cosy, row);
+            if (symmetric)
+                for (size_t j = j0; j < ny; j++)
+                    iout [j * nx + i] = row [j];
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    UNPROTECT (nprot);
+
+    return out;
+}
+
+//' R_haversine_single
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_haversine_single (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return single_dists (x_, y_, threads_, MEASURE_HAVERSINE);
+}
+
+//' R_cheap_single
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)],
+//' or NULL
+//' @noRd
+SEXP R_cheap_single (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return single_dists (x_, y_, threads_, MEASURE_CHEAP);
+}
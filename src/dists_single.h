@@ -0,0 +1,15 @@
+#ifndef DISTS_SINGLE_H
+#define DISTS_SINGLE_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
+
+SEXP R_haversine_single (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_single (SEXP x_, SEXP y_, SEXP threads_);
+
+#endif /* DISTS_SINGLE_H */
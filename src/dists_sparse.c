@@ -0,0 +1,91 @@
+#include "dists_sparse.h"
+
+//' Sparse distance matrix of all pairs of points within a given distance
+//'
+//' All pairs are found with a grid over y, or over x if y is NULL, with
+//' cells sized to the maximal distance, so that each point is only compared
+//' with the points of neighbouring cells, and work scales with the number of
+//' pairs returned rather than with the full matrix. Distances are identical
+//' to those of the corresponding full matrices, including the cheap
+//' multiplier of both sets of points.
+//'
+//' @param y_ Optional second set of points, or NULL for all pairs of x, in
+//' which case each pair of the upper triangle is returned once only.
+//' @param r_ Maximal distance in metres
+//' @return As for `within_grid_search()`
+//' @noRd
+static SEXP sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_,
+        measure_t measure)
+{
+    int upper = Rf_isNull (y_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    double radius = Rf_asReal (r_);
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    y_ = PROTECT (upper ? x_ : Rf_coerceVector (y_, REALSXP));
+    size_t ny = upper ? nx : (size_t) (floor (length (y_) / 2));
+
+    double *rx = REAL (x_), *ry = REAL (y_);
+    point_tables px;
+    point_tables_init (measure, rx, rx + nx, nx, &px);
+    if (!upper)
+        coords_validate (ry, ry + ny, ny);
+
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = upper ? cheap_cosy (rx + nx, nx, NULL, 0) :
+            cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    nn_grid g;
+    nn_grid_init (measure, ry, ry + ny, ny, radius, cosy, &g);
+    SEXP out = within_grid_search (&g, &px, radius, upper, nthreads);
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_haversine_sparse
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Optional additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)], or NULL
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_haversine_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_)
+{
+    return sparse (x_, y_, r_, threads_, MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_sparse
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Optional additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)], or NULL
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_vincenty_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_)
+{
+    return sparse (x_, y_, r_, threads_, MEASURE_VINCENTY);
+}
+
+//' R_cheap_sparse
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Optional additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)], or NULL
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_cheap_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_)
+{
+    return sparse (x_, y_, r_, threads_, MEASURE_CHEAP);
+}
+
+//' R_geodesic_sparse
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Optional additional vector of x-values in [1:n], y-values in
+//' [n+(1:n)], or NULL
+//' @param r_ Maximal distance in metres
+//' @noRd
+SEXP R_geodesic_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_)
+{
+    return sparse (x_, y_, r_, threads_, MEASURE_GEODESIC);
+}
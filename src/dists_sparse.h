@@ -0,0 +1,19 @@
+#ifndef DISTS_SPARSE_H
+#define DISTS_SPARSE_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "grid.h"
+#include "threads.h"
+#include "dists_knn.h"
+
+SEXP R_haversine_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_);
+SEXP R_vincenty_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_);
+SEXP R_cheap_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_);
+SEXP R_geodesic_sparse (SEXP x_, SEXP y_, SEXP r_, SEXP threads_);
+
+#endif /* DISTS_SPARSE_H */
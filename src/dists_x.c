@@ -1,176 +1,65 @@
 #include "dists_x.h"
 
-//' R_haversine
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @noRd
-SEXP R_haversine (SEXP x_)
+static SEXP x_dists (measure_t measure, SEXP x_, SEXP threads_)
 {
     size_t n = (size_t) (floor (length (x_) / 2));
-    //Rprintf ("n = %d ; len = %d \n", n, n2);
-    size_t n2 = n * n;
-    double cosy1 [n]; // y-values are indexed in [n+1:n]
+    int nthreads = get_num_threads (threads_);
 
-    double *rx, *rout;
-    size_t indx1, indx2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
+    SEXP out = PROTECT (allocVector (REALSXP, n * n));
     x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
 
-    rx = REAL (x_);
-    rout = REAL (out);
+    double *rx = REAL (x_);
+
+    point_tables p;
+    point_tables_init (measure, rx, rx + n, n, &p);
 
-    for (size_t i = 0; i < n; i++)
-    {
-        cosy1 [i] = cos (rx [n + i] * M_PI / 180.0);
-        rout [i * n + i] = 0.0;
-    }
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + n, n, NULL, 0);
 
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            indx1 = i * n + j;
-            indx2 = j * n + i;
-            rout [indx1] = rout [indx2] = one_haversine (rx [i], rx [n + i],
-                    rx [j], rx [n + j], cosy1 [i], cosy1 [j]);
-        }
-    }
+    kernel_tri_dists (measure, &p, cosy, 0, nthreads, REAL (out));
 
     UNPROTECT (2);
 
     return out;
 }
 
-//' R_vincenty
+//' R_haversine
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_vincenty (SEXP x_)
+SEXP R_haversine (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    size_t n2 = n * n;
-    //Rprintf ("n = %d ; len = %d \n", n, n2);
-
-    double *rx, *rout;
-    double siny1 [n], cosy1 [n]; // y-values are indexed in [n+1:n]
-    size_t indx1, indx2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < n; i++)
-    {
-        cosy1 [i] = cos (rx [n + i] * M_PI / 180.0);
-        siny1 [i] = sin (rx [n + i] * M_PI / 180.0);
-        rout [i * n + i] = 0.0;
-    }
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            indx1 = i * n + j;
-            indx2 = j * n + i;
-            rout [indx1] = rout [indx2] = one_vincenty (rx [i], rx [j],
-                    siny1 [i], cosy1 [i], siny1 [j], cosy1 [j]);
-        }
-    }
-
-    UNPROTECT (2);
+    return x_dists (MEASURE_HAVERSINE, x_, threads_);
+}
 
-    return out;
+//' R_vincenty
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_vincenty (SEXP x_, SEXP threads_)
+{
+    return x_dists (MEASURE_VINCENTY, x_, threads_);
 }
 
 //' R_cheap
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_cheap (SEXP x_)
+SEXP R_cheap (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    size_t n2 = n * n;
-
-    double *rx, *rout;
-    double ymin = 9999.9, ymax = -9999.9;
-    double cosy;
-    size_t indx1, indx2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    rout = REAL (out);
-
-    // Get maximal latitude range
-    for (size_t i = 0; i < n; i++)
-    {
-        if (rx [n + i] < ymin)
-            ymin = rx [n + i];
-        if (rx [n + i] > ymax)
-            ymax = rx [n + i];
-        rout [i * n + i] = 0.0;
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            indx1 = i * n + j;
-            indx2 = j * n + i;
-            rout [indx1] = rout [indx2] = one_cheap (rx [i], rx [n + i],
-                    rx [j], rx [n + j], cosy);
-        }
-    }
-
-    UNPROTECT (2);
-
-    return out;
+    return x_dists (MEASURE_CHEAP, x_, threads_);
 }
 
 //' R_geodesic
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_geodesic (SEXP x_)
+SEXP R_geodesic (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    size_t n2 = n * n;
-    double *rx, *rout;
-    size_t indx1, indx2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-
-    rx = REAL (x_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < n; i++)
-        rout [i * n + i] = 0.0;
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            indx1 = i * n + j;
-            indx2 = j * n + i;
-            rout [indx1] = rout [indx2] = one_geodesic (rx [i], rx [n + i],
-                    rx [j], rx [n + j]);
-        }
-    }
-
-    UNPROTECT (2);
+    return x_dists (MEASURE_GEODESIC, x_, threads_);
+}
 
-    return out;
+//' R_ruler
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_ruler (SEXP x_, SEXP threads_)
+{
+    return x_dists (MEASURE_RULER, x_, threads_);
 }
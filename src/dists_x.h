@@ -8,10 +8,13 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
 
-SEXP R_haversine (SEXP x_);
-SEXP R_vincenty (SEXP x_);
-SEXP R_cheap (SEXP x_);
-SEXP R_geodesic (SEXP x_);
+SEXP R_haversine (SEXP x_, SEXP threads_);
+SEXP R_vincenty (SEXP x_, SEXP threads_);
+SEXP R_cheap (SEXP x_, SEXP threads_);
+SEXP R_geodesic (SEXP x_, SEXP threads_);
+SEXP R_ruler (SEXP x_, SEXP threads_);
 
 #endif /* DISTS_X_H */
@@ -0,0 +1,76 @@
+#include "dists_x_dist.h"
+
+//' Condensed distance matrix of x
+//'
+//' Values are the upper triangle of the full matrix of 'R_haversine' and
+//' friends, in row-major order. This is the same order as the lower triangle
+//' in column-major order, as used by R's 'dist' objects, and so each row of
+//' the triangle is written contiguously.
+//'
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @return Vector of n * (n - 1) / 2 distances
+//' @noRd
+static SEXP x_dist (SEXP x_, SEXP threads_, measure_t measure)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+    size_t nout = (n > 1) ? n * (n - 1) / 2 : 0;
+
+    SEXP out = PROTECT (allocVector (REALSXP, nout));
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+
+    double *rx = REAL (x_);
+
+    point_tables p;
+    point_tables_init (measure, rx, rx + n, n, &p);
+
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + n, n, NULL, 0);
+
+    kernel_tri_dists (measure, &p, cosy, 1, nthreads, REAL (out));
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_haversine_dist
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_haversine_dist (SEXP x_, SEXP threads_)
+{
+    return x_dist (x_, threads_, MEASURE_HAVERSINE);
+}
+
+//' R_vincenty_dist
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_vincenty_dist (SEXP x_, SEXP threads_)
+{
+    return x_dist (x_, threads_, MEASURE_VINCENTY);
+}
+
+//' R_cheap_dist
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_cheap_dist (SEXP x_, SEXP threads_)
+{
+    return x_dist (x_, threads_, MEASURE_CHEAP);
+}
+
+//' R_geodesic_dist
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_geodesic_dist (SEXP x_, SEXP threads_)
+{
+    return x_dist (x_, threads_, MEASURE_GEODESIC);
+}
+
+//' R_ruler_dist
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_ruler_dist (SEXP x_, SEXP threads_)
+{
+    return x_dist (x_, threads_, MEASURE_RULER);
+}
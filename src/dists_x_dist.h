@@ -0,0 +1,18 @@
+#ifndef DISTS_X_DIST_H
+#define DISTS_X_DIST_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
+
+SEXP R_haversine_dist (SEXP x_, SEXP threads_);
+SEXP R_vincenty_dist (SEXP x_, SEXP threads_);
+SEXP R_cheap_dist (SEXP x_, SEXP threads_);
+SEXP R_geodesic_dist (SEXP x_, SEXP threads_);
+SEXP R_ruler_dist (SEXP x_, SEXP threads_);
+
+#endif /* DISTS_X_DIST_H */
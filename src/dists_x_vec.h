@@ -8,10 +8,13 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
 
-SEXP R_haversine_vec (SEXP x_, SEXP y_);
-SEXP R_vincenty_vec (SEXP x_, SEXP y_);
-SEXP R_cheap_vec (SEXP x_, SEXP y_);
-SEXP R_geodesic_vec (SEXP x_, SEXP y_);
+SEXP R_haversine_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_vec (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_vec (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* DISTS_X_VEC_H */
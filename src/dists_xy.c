@@ -1,18 +1,19 @@
 #include "dists_xy.h"
 
-//' R_haversine_xy
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' Distances between all points of x and y
+//'
+//' @param yrange_ Latitude range of cheap distances, or R_NilValue to take
+//' the range of x and y.
 //' @noRd
-SEXP R_haversine_xy (SEXP x_, SEXP y_)
+static SEXP xy_dists (measure_t measure, SEXP x_, SEXP y_, SEXP yrange_,
+        SEXP threads_)
 {
     size_t nx = (size_t) (floor (length (x_) / 2));
     size_t ny = (size_t) (floor (length (y_) / 2));
+    int nthreads = get_num_threads (threads_);
     size_t n2 = nx * ny;
-    //Rprintf ("(nx, ny) = (%d , %d )\n", nx, ny);
-    //
-    double *rx, *ry, *rout;
-    double cosy1, cosy2;
+
+    double *rx, *ry;
 
     SEXP out = PROTECT (allocVector (REALSXP, n2));
     x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
@@ -20,122 +21,62 @@ SEXP R_haversine_xy (SEXP x_, SEXP y_)
 
     rx = REAL (x_);
     ry = REAL (y_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        cosy1 = cos (rx [nx + i] * M_PI / 180.0); // y-value of x data
-        for (size_t j = 0; j < ny; j++)
-        {
-            cosy2 = cos (ry [ny + j] * M_PI / 180.0);
-            rout [i * ny + j] = one_haversine (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j], cosy1, cosy2);
-        }
-    }
+
+    point_tables p1, p2;
+    point_tables_init (measure, rx, rx + nx, nx, &p1);
+    point_tables_init (measure, ry, ry + ny, ny, &p2);
+
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP && yrange_ != R_NilValue)
+        cosy = cheap_cosy (REAL (yrange_), (size_t) length (yrange_), NULL, 0);
+    else if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    kernel_xy_dists (measure, &p1, &p2, cosy, nthreads, REAL (out));
 
     UNPROTECT (3);
 
     return out;
 }
 
-//' R_vincenty_xy
+//' R_haversine_xy
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_vincenty_xy (SEXP x_, SEXP y_)
+SEXP R_haversine_xy (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-    size_t n2 = nx * ny;
-
-    double *rx, *ry, *rout;
-    double siny1, cosy1, siny2, cosy2;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        siny1 = sin (rx [nx + i] * M_PI / 180.0); // y-value of x data
-        cosy1 = cos (rx [nx + i] * M_PI / 180.0); // y-value of x data
-        for (size_t j = 0; j < ny; j++)
-        {
-            siny2 = sin (ry [ny + j] * M_PI / 180.0);
-            cosy2 = cos (ry [ny + j] * M_PI / 180.0);
-            rout [i * ny + j] = one_vincenty (rx [i], ry [j],
-                    siny1, cosy1, siny2, cosy2);
-        }
-    }
-
-    UNPROTECT (3);
+    return xy_dists (MEASURE_HAVERSINE, x_, y_, R_NilValue, threads_);
+}
 
-    return out;
+//' R_vincenty_xy
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_vincenty_xy (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_dists (MEASURE_VINCENTY, x_, y_, R_NilValue, threads_);
 }
 
 //' R_cheap_xy
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_cheap_xy (SEXP x_, SEXP y_)
+SEXP R_cheap_xy (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-    size_t n2 = nx * ny;
-
-    double *rx, *ry, *rout;
-    double ymin = 9999.9, ymax = -9999.9;
-    double cosy;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    // Get maximal latitude range
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (rx [nx + i] < ymin)
-            ymin = rx [nx + i];
-        if (rx [nx + i] > ymax)
-            ymax = rx [nx + i];
-    }
-    for (size_t i = 0; i < ny; i++)
-    {
-        if (ry [ny + i] < ymin)
-            ymin = ry [ny + i];
-        if (ry [ny + i] > ymax)
-            ymax = ry [ny + i];
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
-
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = 0; j < ny; j++)
-        {
-            rout [i * ny + j] = one_cheap (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j], cosy);
-        }
-    }
-
-    UNPROTECT (3);
+    return xy_dists (MEASURE_CHEAP, x_, y_, R_NilValue, threads_);
+}
 
-    return out;
+//' R_cheap_xy_chunk
+//'
+//' Cheap distances between one block of rows of x and all of y, with the
+//' constant cosine multiplier of the full latitude range of both, so that
+//' blocks are identical to the corresponding rows of `R_cheap_xy()`.
+//'
+//' @param yrange_ Finite minimum and maximum latitudes of all of x and y, or
+//' an empty vector where there are none.
+//' @noRd
+SEXP R_cheap_xy_chunk (SEXP x_, SEXP y_, SEXP yrange_, SEXP threads_)
+{
+    return xy_dists (MEASURE_CHEAP, x_, y_, yrange_, threads_);
 }
 
 
@@ -143,34 +84,16 @@ SEXP R_cheap_xy (SEXP x_, SEXP y_)
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_geodesic_xy (SEXP x_, SEXP y_)
+SEXP R_geodesic_xy (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-    size_t n2 = nx * ny;
-
-    double *rx, *ry, *rout;
-
-    SEXP out = PROTECT (allocVector (REALSXP, n2));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
-
-    rx = REAL (x_);
-    ry = REAL (y_);
-    rout = REAL (out);
-
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        for (size_t j = 0; j < ny; j++)
-        {
-            rout [i * ny + j] = one_geodesic (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j]);
-        }
-    }
-
-    UNPROTECT (3);
+    return xy_dists (MEASURE_GEODESIC, x_, y_, R_NilValue, threads_);
+}
 
-    return out;
+//' R_ruler_xy
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_ruler_xy (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_dists (MEASURE_RULER, x_, y_, R_NilValue, threads_);
 }
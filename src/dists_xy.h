@@ -8,10 +8,14 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
 
-SEXP R_haversine_xy (SEXP x_, SEXP y_);
-SEXP R_vincenty_xy (SEXP x_, SEXP y_);
-SEXP R_cheap_xy (SEXP x_, SEXP y_);
-SEXP R_geodesic_xy (SEXP x_, SEXP y_);
+SEXP R_haversine_xy (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_xy (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_xy (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_xy_chunk (SEXP x_, SEXP y_, SEXP yrange_, SEXP threads_);
+SEXP R_geodesic_xy (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_xy (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* DISTS_XY_H */
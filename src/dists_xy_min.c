@@ -1,122 +1,266 @@
 #include "dists_xy_min.h"
 
-//' R_haversine_xy
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+// Latitudinal lower bounds are deflated by these tolerances before pruning, so
+// candidates are never lost to rounding differences between the bounds and the
+// actual distance calculations.
+#define MIN_REL_TOL 1.0e-9
+#define MIN_ABS_TOL 1.0e-9
+
+// Points of y in order of latitude
+typedef struct
+{
+    double lat;
+    size_t j;
+} lat_index;
+
+static int lat_index_cmp (const void *a, const void *b)
+{
+    const lat_index *la = (const lat_index *) a, *lb = (const lat_index *) b;
+    if (la->lat < lb->lat)
+        return -1;
+    if (la->lat > lb->lat)
+        return 1;
+    return (la->j < lb->j) ? -1 : (la->j > lb->j);
+}
+
+// Points and per-point values for one brute-force search
+typedef struct
+{
+    const point_tables *p1, *p2;
+    double cosy;
+    measure_t measure;
+    int chord; // 1 to compare squared chord lengths of unit vectors
+} min_ctx;
+
+//' Distance between point i of x and point j of y, or any value monotonic in
+//' that distance
+//'
+//' Haversine points with unit vectors are compared by squared chord lengths,
+//' without any inverse trigonometric functions.
 //' @noRd
-SEXP R_haversine_xy_min (SEXP x_, SEXP y_)
+static double min_dist (const min_ctx *c, size_t i, size_t j)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-    
-    double *rx, *ry;
-    double cosy1, cosy2;
-    double d, dmin = 0;
-    int *iout;
-    int jmin = -1;
+    if (c->chord)
+        return chord2 (c->p1->u + 3 * i, c->p2->u + 3 * j);
+    return kernel_pair (c->measure, c->p1, i, c->p2, j, c->cosy);
+}
 
-    SEXP out = PROTECT (allocVector (INTSXP, nx));
+//' Lower bound on the distance between points separated by a given
+//' difference in latitude, regardless of their longitudes, in the same units
+//' as `min_dist()`
+//' @param dlat Absolute difference in latitude in degrees
+//' @noRd
+static double min_lat_bound (const min_ctx *c, double dlat)
+{
+    double d;
+    measure_t measure = c->measure;
 
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    if (c->chord)
+    {
+        double theta = dlat * M_PI / 180.0;
+        d = (theta >= M_PI) ? 2.0 : 2.0 * sin (theta / 2.0);
+        d = d * (1.0 - MIN_REL_TOL) - MIN_ABS_TOL;
+        return (d > 0.0) ? d * d : 0.0;
+    }
 
-    rx = REAL (x_);
-    ry = REAL (y_);
+    if (measure == MEASURE_CHEAP)
+        d = meridian * dlat / 180.0;
+    else if (measure == MEASURE_RULER)
+    {
+        // Latitudinal multipliers of the ruler are least at the equator:
+        double e2 = flattening * (2.0 - flattening);
+        d = earth * (1.0 - e2) * dlat * M_PI / 180.0;
+    } else
+    {
+        d = earth * dlat * M_PI / 180.0;
+        if (measure == MEASURE_GEODESIC)
+            d *= geodesic_sphere_ratio;
+    }
+
+    return d * (1.0 - MIN_REL_TOL) - MIN_ABS_TOL;
+}
+
+//' Nearest neighbour of point i of x among the latitude-sorted points of y
+//'
+//' Points of y are scanned outwards from the latitude of point i, stopping
+//' once the latitudinal lower bound exceeds the current minimal distance, so
+//' that the actual distance is only calculated for points within that band.
+//' Ties are resolved in favour of the lowest index, as for an exhaustive scan.
+//'
+//' @return 1-based index into y, or NA if there are no finite distances.
+//' @noRd
+static int xy_min_one (const min_ctx *c, const lat_index *lats, size_t nlat,
+        size_t i)
+{
+    double lon = c->p1->x [i], lat = c->p1->y [i];
+    if (!isfinite (lon) || !isfinite (lat))
+        return NA_INTEGER;
+
+    // first point with latitude >= lat:
+    size_t lo = 0, hi = nlat;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (lats [mid].lat < lat)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    iout = INTEGER (out);
+    // scan outwards, taking whichever of the two cursors is closer in
+    // latitude, with 'down' one position above the next point below
+    size_t down = lo, up = lo;
+    double dmin = DBL_MAX;
+    size_t jmin = 0, neval = 0;
+    int found = 0;
 
-    for (size_t i = 0; i < nx; i++)
+    while (down > 0 || up < nlat)
     {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-                                     //
-        cosy1 = cos (rx [nx + i] * M_PI / 180.0); // y-value of x data
-                                                  //
-        dmin = DBL_MAX;
-        for (size_t j = 0; j < ny; j++)
+        size_t k;
+        if (down == 0)
+            k = up++;
+        else if (up == nlat)
+            k = --down;
+        else if (lat - lats [down - 1].lat <= lats [up].lat - lat)
+            k = --down;
+        else
+            k = up++;
+
+        if (found &&
+                min_lat_bound (c, fabs (lats [k].lat - lat)) > dmin)
+            break;
+
+        size_t j = lats [k].j;
+        double d = min_dist (c, i, j);
+        neval++;
+        if (!ISNAN (d) &&
+                (!found || d < dmin || (d == dmin && j < jmin)))
         {
-            cosy2 = cos (ry [ny + j] * M_PI / 180.0);
-            d = one_haversine (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j], cosy1, cosy2);
-            if (d < dmin)
-            {
-                dmin = d;
-                jmin = j;
-            }
+            dmin = d;
+            jmin = j;
+            found = 1;
         }
-        iout [i] = jmin + 1L;
     }
+    stats_count ((double) neval);
 
-    UNPROTECT (3);
-
-    return out;
+    return found ? (int) jmin + 1L : NA_INTEGER;
 }
 
-//' R_vincenty_xy
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' Brute-force nearest neighbours, pruned by latitude
+//'
+//' Points of y are sorted by latitude once, and each point of x then searched
+//' with `xy_min_one()`, in parallel over blocks of x. The cost of each search
+//' varies with the local density of y, so blocks are scheduled dynamically.
+//'
+//' @param p1, p2 Points and per-point terms from `point_tables_init()`, or
+//' from prepared points.
+//' @param cosy Constant cosine multiplier for cheap distances
+//' @param iout Filled with 1-based indices into p2, or NA.
 //' @noRd
-SEXP R_vincenty_xy_min (SEXP x_, SEXP y_)
+void xy_min_tables (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, int *iout)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-
-    double *rx, *ry;
-    double siny1, cosy1, siny2, cosy2;
-    double d, dmin = 0;
-    int *iout;
-    int jmin = -1;
+    min_ctx c = {p1, p2, cosy, measure,
+        measure == MEASURE_HAVERSINE && p1->u && p2->u};
+    size_t ny = p2->n;
 
-    SEXP out = PROTECT (allocVector (INTSXP, nx));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    lat_index *lats = (lat_index *) stats_alloc (ny, sizeof (lat_index));
+    size_t nlat = 0;
+    for (size_t j = 0; j < ny; j++)
+    {
+        if (isfinite (p2->x [j]) && isfinite (p2->y [j]))
+        {
+            lats [nlat].lat = p2->y [j];
+            lats [nlat++].j = j;
+        }
+    }
+    qsort (lats, nlat, sizeof (lat_index), lat_index_cmp);
+    stats_counting ();
 
-    rx = REAL (x_);
-    ry = REAL (y_);
-    iout = INTEGER (out);
+    size_t nblocks;
+    size_t *blocks = row_blocks (p1->n, nthreads, &nblocks);
+    volatile int interrupted = 0;
 
-    for (size_t i = 0; i < nx; i++)
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
     {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        siny1 = sin (rx [nx + i] * M_PI / 180.0); // y-value of x data
-        cosy1 = cos (rx [nx + i] * M_PI / 180.0); // y-value of x data
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+            iout [i] = xy_min_one (&c, lats, nlat, i);
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Nearest neighbours of (x, y) among the points of a kd-tree
+//'
+//' Haversine neighbours are ranked by chord lengths with 'options
+//' (geodist.chord = TRUE)', as in the brute-force scan.
+//'
+//' Searches are made in worker threads, and so failures of the tree are only
+//' flagged there, and raised once all threads have finished.
+//'
+//' @param iout Filled with 1-based indices into the points of the tree, or NA
+//' for points with non-finite coordinates.
+//' @noRd
+void xy_min_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, int nthreads, int *iout)
+{
+    size_t nblocks;
+    size_t *blocks = row_blocks (nx, nthreads, &nblocks);
+    volatile int interrupted = 0, failed = 0;
+    int chord = t->measure == MEASURE_HAVERSINE && chord_enabled ();
 
-        dmin = DBL_MAX;
-        for (size_t j = 0; j < ny; j++)
+    stats_counting ();
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted || failed)
+            continue;
+        double d;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
         {
-            siny2 = sin (ry [ny + j] * M_PI / 180.0);
-            cosy2 = cos (ry [ny + j] * M_PI / 180.0);
-            d = one_vincenty (rx [i], ry [j],
-                    siny1, cosy1, siny2, cosy2);
-            if (d < dmin)
+            if (!isfinite (x [i]) || !isfinite (y [i]))
+            {
+                iout [i] = NA_INTEGER;
+                continue;
+            }
+            size_t j = chord ? nn_nearest_chord (t, x [i], y [i]) :
+                nn_nearest (t, x [i], y [i], &d);
+            if (j == NN_FAILED)
             {
-                dmin = d;
-                jmin = j;
+                failed = 1; // # nocov
+                break; // # nocov
             }
+            iout [i] = (int) j + 1L;
         }
-        iout [i] = jmin + 1L;
     }
-
-    UNPROTECT (3);
-
-    return out;
+    end_check_interrupt (interrupted);
+    if (failed)
+        Rf_error ("kd-tree search failed"); // # nocov
 }
 
-//' R_cheap_xy
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' Nearest neighbours in y of each point of x
+//'
+//' A kd-tree over y is used for large inputs without non-finite values, and
+//' otherwise the brute-force scan, both of which give identical results.
+//' Ruler multipliers vary between pairs, and so can not bound the searches of
+//' the tree, and ruler distances are always scanned by brute force.
 //' @noRd
-SEXP R_cheap_xy_min (SEXP x_, SEXP y_)
+static SEXP xy_min (measure_t measure, SEXP x_, SEXP y_, SEXP threads_)
 {
     size_t nx = (size_t) (floor (length (x_) / 2));
     size_t ny = (size_t) (floor (length (y_) / 2));
+    int nthreads = get_num_threads (threads_);
 
     double *rx, *ry;
-    double ymin = 9999.9, ymax = -9999.9;
-    double cosy;
-    double d, dmin = 0;
-    int *iout;
-    int jmin = -1;
 
     SEXP out = PROTECT (allocVector (INTSXP, nx));
     x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
@@ -124,93 +268,77 @@ SEXP R_cheap_xy_min (SEXP x_, SEXP y_)
 
     rx = REAL (x_);
     ry = REAL (y_);
-    iout = INTEGER (out);
 
-    // Get maximal latitude range
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (rx [nx + i] < ymin)
-            ymin = rx [nx + i];
-        if (rx [nx + i] > ymax)
-            ymax = rx [nx + i];
-    }
-    for (size_t i = 0; i < ny; i++)
-    {
-        if (ry [ny + i] < ymin)
-            ymin = ry [ny + i];
-        if (ry [ny + i] > ymax)
-            ymax = ry [ny + i];
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + nx, nx, ry + ny, ny);
+
+    // Both sets are always validated, so that ranges are checked whichever
+    // traversal is used, and the masks reused by the brute-force tables:
+    const unsigned char *na1 = coords_validate (rx, rx + nx, nx);
+    const unsigned char *na2 = coords_validate (ry, ry + ny, ny);
 
-    for (size_t i = 0; i < nx; i++)
+    if (measure != MEASURE_RULER && nn_use_tree (nx, ny) &&
+            na1 == NULL && na2 == NULL)
     {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        dmin = DBL_MAX;
-        for (size_t j = 0; j < ny; j++)
-        {
-            d = one_cheap (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j], cosy);
-            if (d < dmin)
-            {
-                dmin = d;
-                jmin = j;
-            }
-        }
-        iout [i] = jmin + 1L;
+        SEXP tree_ = PROTECT (nn_tree_create (ry, ry + ny, ny, measure, cosy));
+        xy_min_tree_search (nn_tree_get (tree_), rx, rx + nx, nx, nthreads,
+                INTEGER (out));
+        UNPROTECT (4);
+        return out;
     }
 
+    point_tables p1, p2;
+    point_tables_init_na (measure, rx, rx + nx, nx, na1, &p1);
+    point_tables_init_na (measure, ry, ry + ny, ny, na2, &p2);
+    xy_min_tables (measure, &p1, &p2, cosy, nthreads, INTEGER (out));
+
     UNPROTECT (3);
 
     return out;
 }
 
-
-//' R_geodesic_xy
+//' R_haversine_xy_min
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
 //' @noRd
-SEXP R_geodesic_xy_min (SEXP x_, SEXP y_)
+SEXP R_haversine_xy_min (SEXP x_, SEXP y_, SEXP threads_)
 {
-    size_t nx = (size_t) (floor (length (x_) / 2));
-    size_t ny = (size_t) (floor (length (y_) / 2));
-
-    double *rx, *ry;
-    double d, dmin = 0;
-    int *iout;
-    int jmin = -1;
+    return xy_min (MEASURE_HAVERSINE, x_, y_, threads_);
+}
 
-    SEXP out = PROTECT (allocVector (INTSXP, nx));
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+//' R_vincenty_xy_min
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_vincenty_xy_min (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_min (MEASURE_VINCENTY, x_, y_, threads_);
+}
 
-    rx = REAL (x_);
-    ry = REAL (y_);
-    iout = INTEGER (out);
+//' R_cheap_xy_min
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_cheap_xy_min (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_min (MEASURE_CHEAP, x_, y_, threads_);
+}
 
-    for (size_t i = 0; i < nx; i++)
-    {
-        if (i % 1000 == 0)
-            R_CheckUserInterrupt (); // # nocov
-        dmin = DBL_MAX;
-        for (size_t j = 0; j < ny; j++)
-        {
-            d = one_geodesic (rx [i], rx [nx + i],
-                    ry [j], ry [ny + j]);
-            if (d < dmin)
-            {
-                dmin = d;
-                jmin = j;
-            }
-        }
-        iout [i] = jmin + 1L;
-    }
 
-    UNPROTECT (3);
+//' R_geodesic_xy_min
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_geodesic_xy_min (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_min (MEASURE_GEODESIC, x_, y_, threads_);
+}
 
-    return out;
+//' R_ruler_xy_min
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param y_ Additional vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_ruler_xy_min (SEXP x_, SEXP y_, SEXP threads_)
+{
+    return xy_min (MEASURE_RULER, x_, y_, threads_);
 }
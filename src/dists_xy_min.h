@@ -4,14 +4,24 @@
 #include <R.h>
 #include <Rinternals.h>
 
-#include <stdio.h> 
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "nearest.h"
+#include "threads.h"
+#include "kernels.h"
 
-SEXP R_haversine_xy_min (SEXP x_, SEXP y_);
-SEXP R_vincenty_xy_min (SEXP x_, SEXP y_);
-SEXP R_cheap_xy_min (SEXP x_, SEXP y_);
-SEXP R_geodesic_xy_min (SEXP x_, SEXP y_);
+void xy_min_tables (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, int *iout);
+void xy_min_tree_search (const nn_tree *t, const double *x, const double *y,
+        size_t nx, int nthreads, int *iout);
+
+SEXP R_haversine_xy_min (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_xy_min (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_xy_min (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_xy_min (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_xy_min (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* DISTS_XY_MIN_H */
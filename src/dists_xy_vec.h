@@ -8,10 +8,18 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "threads.h"
+#include "kernels.h"
 
-SEXP R_haversine_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_vincenty_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_cheap_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
-SEXP R_geodesic_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_);
+SEXP R_haversine_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_vincenty_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_cheap_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_geodesic_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
+SEXP R_ruler_xy_vec (SEXP x1_, SEXP y1_, SEXP x2_, SEXP y2_,
+        SEXP threads_);
 
 #endif /* DISTS_XY_H */
@@ -691,16 +691,31 @@ void geod_direct(const struct geod_geodesic* g,
                  nullptr, nullptr, nullptr, nullptr, nullptr);
 }
 
-static double geod_geninverse_int(const struct geod_geodesic* g,
-                                  double lat1, double lon1,
-                                  double lat2, double lon2,
+void geod_pointinit(const struct geod_geodesic* g,
+                    struct geod_point* p, double lat, double lon) {
+  /* If really close to the equator, treat as on equator. */
+  p->lat = AngRound(LatFix(lat));
+  p->lon = lon;
+  sincosdx(p->lat, &p->sbet, &p->cbet); p->sbet *= g->f1;
+  /* Ensure cbet = +epsilon at poles */
+  norm2(&p->sbet, &p->cbet); p->cbet = fmax(tiny, p->cbet);
+  p->dn = sqrt(1 + g->ep2 * sq(p->sbet));
+}
+
+/* The inverse problem between two points initialized by geod_pointinit().
+ * The latitude-dependent terms of each point are unchanged by the canonical
+ * transformation below other than in the sign of sbet, so they are
+ * calculated once for each point, rather than once for each pair. */
+static double geod_geninverse_pts(const struct geod_geodesic* g,
+                                  const struct geod_point* p1,
+                                  const struct geod_point* p2,
                                   double* ps12,
                                   double* psalp1, double* pcalp1,
                                   double* psalp2, double* pcalp2,
                                   double* pm12, double* pM12, double* pM21,
                                   double* pS12) {
   double s12 = 0, m12 = 0, M12 = 0, M21 = 0, S12 = 0;
-  double lon12, lon12s;
+  double lat1, lon12, lon12s;
   int latsign, lonsign, swapp;
   double sbet1, cbet1, sbet2, cbet2, s12x = 0, m12x = 0;
   double dn1, dn2, lam12, slam12, clam12;
@@ -720,7 +735,7 @@ static double geod_geninverse_int(const struct geod_geodesic* g,
   /* Compute longitude difference (AngDiff does this carefully).  Result is
    * in [-180, 180] but -180 is only for west-going geodesics.  180 is for
    * east-going and meridional geodesics. */
-  lon12 = AngDiff(lon1, lon2, &lon12s);
+  lon12 = AngDiff(p1->lon, p2->lon, &lon12s);
   /* Make longitude difference positive. */
   lonsign = signbit(lon12) ? -1 : 1;
   lon12 *= lonsign; lon12s *= lonsign;
@@ -729,20 +744,17 @@ static double geod_geninverse_int(const struct geod_geodesic* g,
   sincosde(lon12, lon12s, &slam12, &clam12);
   lon12s = (hd - lon12) - lon12s; /* the supplementary longitude difference */
 
-  /* If really close to the equator, treat as on equator. */
-  lat1 = AngRound(LatFix(lat1));
-  lat2 = AngRound(LatFix(lat2));
   /* Swap points so that point with higher (abs) latitude is point 1
    * If one latitude is a nan, then it becomes lat1. */
-  swapp = fabs(lat1) < fabs(lat2) || lat2 != lat2 ? -1 : 1;
+  swapp = fabs(p1->lat) < fabs(p2->lat) || p2->lat != p2->lat ? -1 : 1;
   if (swapp < 0) {
+    const struct geod_point* p = p1;
     lonsign *= -1;
-    swapx(&lat1, &lat2);
+    p1 = p2; p2 = p;
   }
   /* Make lat1 <= -0 */
-  latsign = signbit(lat1) ? 1 : -1;
-  lat1 *= latsign;
-  lat2 *= latsign;
+  latsign = signbit(p1->lat) ? 1 : -1;
+  lat1 = p1->lat * latsign;
   /* Now we have
    *
    *     0 <= lon12 <= 180
@@ -755,13 +767,8 @@ static double geod_geninverse_int(const struct geod_geodesic* g,
    * check, e.g., on verifying quadrants in atan2.  In addition, this
    * enforces some symmetries in the results returned. */
 
-  sincosdx(lat1, &sbet1, &cbet1); sbet1 *= g->f1;
-  /* Ensure cbet1 = +epsilon at poles */
-  norm2(&sbet1, &cbet1); cbet1 = fmax(tiny, cbet1);
-
-  sincosdx(lat2, &sbet2, &cbet2); sbet2 *= g->f1;
-  /* Ensure cbet2 = +epsilon at poles */
-  norm2(&sbet2, &cbet2); cbet2 = fmax(tiny, cbet2);
+  sbet1 = p1->sbet * latsign; cbet1 = p1->cbet; dn1 = p1->dn;
+  sbet2 = p2->sbet * latsign; cbet2 = p2->cbet; dn2 = p2->dn;
 
   /* If cbet1 < -sbet1, then cbet2 - cbet1 is a sensitive measure of the
    * |bet1| - |bet2|.  Alternatively (cbet1 >= -sbet1), abs(sbet2) + sbet1 is
@@ -772,16 +779,15 @@ static double geod_geninverse_int(const struct geod_geodesic* g,
    * which failed with Visual Studio 10 (Release and Debug) */
 
   if (cbet1 < -sbet1) {
-    if (cbet2 == cbet1)
+    if (cbet2 == cbet1) {
       sbet2 = copysign(sbet1, sbet2);
+      dn2 = dn1;
+    }
   } else {
     if (fabs(sbet2) == -sbet1)
       cbet2 = cbet1;
   }
 
-  dn1 = sqrt(1 + g->ep2 * sq(sbet1));
-  dn2 = sqrt(1 + g->ep2 * sq(sbet2));
-
   meridian = lat1 == -qd || slam12 == 0;
 
   if (meridian) {
@@ -1041,6 +1047,45 @@ static double geod_geninverse_int(const struct geod_geodesic* g,
   return a12;
 }
 
+static double geod_geninverse_int(const struct geod_geodesic* g,
+                                  double lat1, double lon1,
+                                  double lat2, double lon2,
+                                  double* ps12,
+                                  double* psalp1, double* pcalp1,
+                                  double* psalp2, double* pcalp2,
+                                  double* pm12, double* pM12, double* pM21,
+                                  double* pS12) {
+  struct geod_point p1, p2;
+  geod_pointinit(g, &p1, lat1, lon1);
+  geod_pointinit(g, &p2, lat2, lon2);
+  return geod_geninverse_pts(g, &p1, &p2, ps12, psalp1, pcalp1,
+                             psalp2, pcalp2, pm12, pM12, pM21, pS12);
+}
+
+void geod_inverse_many(const struct geod_geodesic* g,
+                       const struct geod_point* p1,
+                       size_t n, const struct geod_point* p2,
+                       double* s12) {
+  size_t k;
+  for (k = 0; k < n; ++k)
+    geod_geninverse_pts(g, p1, p2 + k, s12 + k, nullptr, nullptr,
+                        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+}
+
+void geod_inverse_many_azi(const struct geod_geodesic* g,
+                           const struct geod_point* p1,
+                           size_t n, const struct geod_point* p2,
+                           double* s12, double* azi1, double* azi2) {
+  size_t k;
+  double salp1, calp1, salp2, calp2;
+  for (k = 0; k < n; ++k) {
+    geod_geninverse_pts(g, p1, p2 + k, s12 + k, &salp1, &calp1,
+                        &salp2, &calp2, nullptr, nullptr, nullptr, nullptr);
+    azi1[k] = atan2dx(salp1, calp1);
+    azi2[k] = atan2dx(salp2, calp2);
+  }
+}
+
 double geod_geninverse(const struct geod_geodesic* g,
                        double lat1, double lon1, double lat2, double lon2,
                        double* ps12, double* pazi1, double* pazi2,
@@ -75,6 +75,8 @@
 #include "proj_symbol_rename.h"
 #endif
 
+#include <stddef.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -116,6 +118,19 @@ extern "C" {
     unsigned caps;              /**< the capabilities */
   };
 
+  /**
+   * The struct containing the latitude-dependent terms of a single point, for
+   * repeated inverse calculations from or to that point.  This must be
+   * initialized by geod_pointinit() before use.
+   **********************************************************************/
+  struct geod_point {
+    double lat;                 /**< the rounded latitude */
+    double lon;                 /**< the longitude */
+    /**< @cond SKIP */
+    double sbet, cbet, dn;
+    /**< @endcond */
+  };
+
   /**
    * The struct for accumulating information about a geodesic polygon.  This is
    * used for computing the perimeter and area of a polygon.  This must be
@@ -273,6 +288,61 @@ extern "C" {
                              double lat2, double lon2,
                              double* ps12, double* pazi1, double* pazi2);
 
+  /**
+   * Initialize a geod_point object.
+   *
+   * @param[in] g a pointer to the geod_geodesic object specifying the
+   *   ellipsoid.
+   * @param[out] p a pointer to the object to be initialized.
+   * @param[in] lat latitude of the point (degrees).
+   * @param[in] lon longitude of the point (degrees).
+   **********************************************************************/
+  void GEOD_DLL geod_pointinit(const struct geod_geodesic* g,
+                               struct geod_point* p, double lat, double lon);
+
+  /**
+   * Solve the inverse geodesic problem from one point to many.
+   *
+   * @param[in] g a pointer to the geod_geodesic object specifying the
+   *   ellipsoid.
+   * @param[in] p1 a pointer to point 1, initialized by geod_pointinit().
+   * @param[in] n the number of points 2.
+   * @param[in] p2 an array of \e n points 2, initialized by geod_pointinit().
+   * @param[out] s12 an array of \e n distances from point 1 to each point 2
+   *   (meters).
+   *
+   * The results are identical to those of geod_inverse() for each pair, but
+   * the latitude-dependent terms of each point are only calculated once, in
+   * geod_pointinit().
+   **********************************************************************/
+  void GEOD_DLL geod_inverse_many(const struct geod_geodesic* g,
+                                  const struct geod_point* p1,
+                                  size_t n, const struct geod_point* p2,
+                                  double* s12);
+
+  /**
+   * Solve the inverse geodesic problem from one point to many, returning
+   * azimuths as well as distances.
+   *
+   * @param[in] g a pointer to the geod_geodesic object specifying the
+   *   ellipsoid.
+   * @param[in] p1 a pointer to point 1, initialized by geod_pointinit().
+   * @param[in] n the number of points 2.
+   * @param[in] p2 an array of \e n points 2, initialized by geod_pointinit().
+   * @param[out] s12 an array of \e n distances from point 1 to each point 2
+   *   (meters).
+   * @param[out] azi1 an array of \e n azimuths at point 1 (degrees).
+   * @param[out] azi2 an array of \e n (forward) azimuths at each point 2
+   *   (degrees).
+   *
+   * The results are identical to those of geod_inverse() for each pair.
+   **********************************************************************/
+  void GEOD_DLL geod_inverse_many_azi(const struct geod_geodesic* g,
+                                      const struct geod_point* p1,
+                                      size_t n, const struct geod_point* p2,
+                                      double* s12, double* azi1,
+                                      double* azi2);
+
   /**
    * The general inverse geodesic calculation.
    *
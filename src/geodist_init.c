@@ -3,109 +3,495 @@
 #include <stdlib.h> // for NULL
 #include <R_ext/Rdynload.h>
 
+#include "async.h"
+#include "common.h"
+#include "dists_file.h"
+#include "prepared.h"
+#include "stats.h"
+
 /* FIXME: 
    Check these declarations against the C/Fortran source code.
 */
 
 /* .Call calls */
-extern SEXP R_cheap(SEXP);
-extern SEXP R_cheap_paired(SEXP, SEXP);
-extern SEXP R_cheap_paired_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_cheap_range(SEXP);
-extern SEXP R_cheap_seq(SEXP);
+extern SEXP R_async_cancel(SEXP);
+extern SEXP R_async_result(SEXP);
+extern SEXP R_async_status(SEXP);
+extern SEXP R_auto(SEXP, SEXP, SEXP);
+extern SEXP R_auto_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_auto_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_auto_seq(SEXP, SEXP, SEXP);
+extern SEXP R_auto_seq_vec(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_auto_vec(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_auto_xy(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_auto_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_batch_vectorised(void);
+extern SEXP R_cheap(SEXP, SEXP);
+extern SEXP R_cheap_async(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_dist(SEXP, SEXP);
+extern SEXP R_cheap_file_min(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_file_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_file_seq(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_file_range(SEXP, SEXP);
+extern SEXP R_cheap_knn(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_paired(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_prepare(SEXP);
+extern SEXP R_cheap_range(SEXP, SEXP);
+extern SEXP R_cheap_range_bounds(SEXP, SEXP);
+extern SEXP R_cheap_reduce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_seq(SEXP, SEXP);
+extern SEXP R_cheap_seq_groups(SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_cheap_seq_range(SEXP);
-extern SEXP R_cheap_seq_vec(SEXP, SEXP);
-extern SEXP R_cheap_vec(SEXP, SEXP);
-extern SEXP R_cheap_xy(SEXP, SEXP);
-extern SEXP R_cheap_xy_min(SEXP, SEXP);
-extern SEXP R_cheap_xy_range(SEXP, SEXP);
-extern SEXP R_cheap_xy_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_geodesic(SEXP);
-extern SEXP R_geodesic_paired(SEXP, SEXP);
-extern SEXP R_geodesic_paired_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_geodesic_range(SEXP);
-extern SEXP R_geodesic_seq(SEXP);
+extern SEXP R_cheap_seq_stream(void);
+extern SEXP R_cheap_seq_vec(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_single(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_sparse(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_vec(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_within(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_xy(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_xy_chunk(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_cheap_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_cheap_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic(SEXP, SEXP);
+extern SEXP R_geodesic_async(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_dist(SEXP, SEXP);
+extern SEXP R_geodesic_file_min(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_file_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_file_seq(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_file_range(SEXP, SEXP);
+extern SEXP R_geodesic_knn(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_paired(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_paired_azimuth(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_prepare(SEXP);
+extern SEXP R_geodesic_range(SEXP, SEXP);
+extern SEXP R_geodesic_range_bounds(SEXP, SEXP);
+extern SEXP R_geodesic_reduce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_seq(SEXP, SEXP);
+extern SEXP R_geodesic_seq_azimuth(SEXP, SEXP);
+extern SEXP R_geodesic_seq_groups(SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_geodesic_seq_range(SEXP);
-extern SEXP R_geodesic_seq_vec(SEXP, SEXP);
-extern SEXP R_geodesic_vec(SEXP, SEXP);
-extern SEXP R_geodesic_xy(SEXP, SEXP);
-extern SEXP R_geodesic_xy_min(SEXP, SEXP);
-extern SEXP R_geodesic_xy_range(SEXP, SEXP);
-extern SEXP R_geodesic_xy_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_haversine(SEXP);
-extern SEXP R_haversine_paired(SEXP, SEXP);
-extern SEXP R_haversine_paired_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_haversine_range(SEXP);
-extern SEXP R_haversine_seq(SEXP);
+extern SEXP R_geodesic_seq_stream(void);
+extern SEXP R_geodesic_seq_vec(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_sparse(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_vec(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_within(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_xy(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_xy_azimuth(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_geodesic_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine(SEXP, SEXP);
+extern SEXP R_haversine_async(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_dist(SEXP, SEXP);
+extern SEXP R_haversine_file_min(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine_file_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine_file_seq(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_file_range(SEXP, SEXP);
+extern SEXP R_haversine_knn(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_paired(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine_prepare(SEXP);
+extern SEXP R_haversine_range(SEXP, SEXP);
+extern SEXP R_haversine_range_bounds(SEXP, SEXP);
+extern SEXP R_haversine_reduce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine_seq(SEXP, SEXP);
+extern SEXP R_haversine_seq_groups(SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_haversine_seq_range(SEXP);
-extern SEXP R_haversine_seq_vec(SEXP, SEXP);
-extern SEXP R_haversine_vec(SEXP, SEXP);
-extern SEXP R_haversine_xy(SEXP, SEXP);
-extern SEXP R_haversine_xy_min(SEXP, SEXP);
-extern SEXP R_haversine_xy_range(SEXP, SEXP);
-extern SEXP R_haversine_xy_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_vincenty(SEXP);
-extern SEXP R_vincenty_paired(SEXP, SEXP);
-extern SEXP R_vincenty_paired_vec(SEXP, SEXP, SEXP, SEXP);
-extern SEXP R_vincenty_range(SEXP);
-extern SEXP R_vincenty_seq(SEXP);
+extern SEXP R_haversine_seq_stream(void);
+extern SEXP R_haversine_seq_vec(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_single(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_sparse(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_haversine_vec(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_within(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_xy(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_haversine_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_prepared_knn(SEXP, SEXP, SEXP);
+extern SEXP R_prepared_within(SEXP, SEXP, SEXP);
+extern SEXP R_prepared_xy(SEXP, SEXP, SEXP);
+extern SEXP R_prepared_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_prepared_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_ruler(SEXP, SEXP);
+extern SEXP R_ruler_async(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_dist(SEXP, SEXP);
+extern SEXP R_ruler_file_min(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_ruler_file_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_ruler_file_range(SEXP, SEXP);
+extern SEXP R_ruler_file_seq(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_paired(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_ruler_range(SEXP, SEXP);
+extern SEXP R_ruler_reduce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_ruler_seq(SEXP, SEXP);
+extern SEXP R_ruler_seq_range(SEXP);
+extern SEXP R_ruler_seq_vec(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_vec(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_xy(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_ruler_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_seq_stream_append(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_seq_stream_stats(SEXP);
+extern SEXP R_stats(SEXP, SEXP);
+extern SEXP R_vincenty(SEXP, SEXP);
+extern SEXP R_vincenty_async(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_dist(SEXP, SEXP);
+extern SEXP R_vincenty_file_min(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_file_paired(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_file_seq(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_file_range(SEXP, SEXP);
+extern SEXP R_vincenty_knn(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_paired(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_paired_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_prepare(SEXP);
+extern SEXP R_vincenty_range(SEXP, SEXP);
+extern SEXP R_vincenty_range_bounds(SEXP, SEXP);
+extern SEXP R_vincenty_reduce(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_seq(SEXP, SEXP);
+extern SEXP R_vincenty_seq_groups(SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_vincenty_seq_range(SEXP);
-extern SEXP R_vincenty_seq_vec(SEXP, SEXP);
-extern SEXP R_vincenty_vec(SEXP, SEXP);
-extern SEXP R_vincenty_xy(SEXP, SEXP);
-extern SEXP R_vincenty_xy_min(SEXP, SEXP);
-extern SEXP R_vincenty_xy_range(SEXP, SEXP);
-extern SEXP R_vincenty_xy_vec(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_seq_stream(void);
+extern SEXP R_vincenty_seq_vec(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_sparse(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_vec(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_within(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_xy(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_xy_min(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_xy_range(SEXP, SEXP, SEXP);
+extern SEXP R_vincenty_xy_vec(SEXP, SEXP, SEXP, SEXP, SEXP);
+
+/* Instrumented wrappers of all .Call calls, which record times, numbers of
+   pairs of points, threads, and bytes allocated when
+   'geodist_stats (enable = TRUE)'; see stats.c */
+#define P0 (void)
+#define P1 (SEXP a)
+#define P2 (SEXP a, SEXP b)
+#define P3 (SEXP a, SEXP b, SEXP c)
+#define P4 (SEXP a, SEXP b, SEXP c, SEXP d)
+#define P5 (SEXP a, SEXP b, SEXP c, SEXP d, SEXP e)
+#define P6 (SEXP a, SEXP b, SEXP c, SEXP d, SEXP e, SEXP f)
+#define A0 ()
+#define A1 (a)
+#define A2 (a, b)
+#define A3 (a, b, c)
+#define A4 (a, b, c, d)
+#define A5 (a, b, c, d, e)
+#define A6 (a, b, c, d, e, f)
+
+#define STATS_CALL(fn, params, args, pairs) \
+    static SEXP S_##fn params \
+    { \
+        if (!stats_on) \
+            return fn args; \
+        stats_begin (); \
+        SEXP res = PROTECT (fn args); \
+        stats_end (#fn, res, pairs); \
+        UNPROTECT (1); \
+        return res; \
+    }
+
+STATS_CALL (R_async_cancel, P1, A1, 0.0)
+STATS_CALL (R_async_result, P1, A1, 0.0)
+STATS_CALL (R_async_status, P1, A1, 0.0)
+STATS_CALL (R_auto, P3, A3, stats_pairs_x (a))
+STATS_CALL (R_auto_paired, P4, A4, stats_pairs_paired (a))
+STATS_CALL (R_auto_paired_vec, P6, A6, stats_pairs_paired_vec (a))
+STATS_CALL (R_auto_seq, P3, A3, stats_pairs_seq (a))
+STATS_CALL (R_auto_seq_vec, P4, A4, stats_pairs_seq_vec (a))
+STATS_CALL (R_auto_vec, P4, A4, stats_pairs_x_vec (a))
+STATS_CALL (R_auto_xy, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_auto_xy_vec, P6, A6, stats_pairs_xy_vec (a, c))
+STATS_CALL (R_cheap, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_cheap_async, P3, A3, 0.0)
+STATS_CALL (R_cheap_dist, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_cheap_file_min, P4, A4, stats_pairs_file_xy (a, b))
+STATS_CALL (R_cheap_file_paired, P4, A4, stats_pairs_file_paired (a))
+STATS_CALL (R_cheap_file_seq, P3, A3, stats_pairs_file_seq (a))
+STATS_CALL (R_cheap_file_range, P2, A2, stats_pairs_file_seq (a))
+STATS_CALL (R_cheap_knn, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_paired, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_cheap_paired_vec, P5, A5, stats_pairs_paired_vec (a))
+STATS_CALL (R_cheap_prepare, P1, A1, 0.0)
+STATS_CALL (R_cheap_range, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_cheap_range_bounds, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_cheap_reduce, P6, A6, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_seq, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_cheap_seq_groups, P5, A5, stats_pairs_groups (a, b, c))
+STATS_CALL (R_cheap_seq_range, P1, A1, stats_pairs_seq (a))
+STATS_CALL (R_cheap_seq_stream, P0, A0, 0.0)
+STATS_CALL (R_cheap_seq_vec, P3, A3, stats_pairs_seq_vec (a))
+STATS_CALL (R_cheap_single, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_sparse, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_vec, P3, A3, stats_pairs_x_vec (a))
+STATS_CALL (R_cheap_within, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_xy, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_xy_chunk, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_xy_min, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_xy_range, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_cheap_xy_vec, P5, A5, stats_pairs_xy_vec (a, c))
+STATS_CALL (R_geodesic, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_geodesic_async, P3, A3, 0.0)
+STATS_CALL (R_geodesic_dist, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_geodesic_file_min, P4, A4, stats_pairs_file_xy (a, b))
+STATS_CALL (R_geodesic_file_paired, P4, A4, stats_pairs_file_paired (a))
+STATS_CALL (R_geodesic_file_seq, P3, A3, stats_pairs_file_seq (a))
+STATS_CALL (R_geodesic_file_range, P2, A2, stats_pairs_file_seq (a))
+STATS_CALL (R_geodesic_knn, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_paired, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_geodesic_paired_azimuth, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_geodesic_paired_vec, P5, A5, stats_pairs_paired_vec (a))
+STATS_CALL (R_geodesic_prepare, P1, A1, 0.0)
+STATS_CALL (R_geodesic_range, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_geodesic_range_bounds, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_geodesic_reduce, P6, A6, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_seq, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_geodesic_seq_azimuth, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_geodesic_seq_groups, P5, A5, stats_pairs_groups (a, b, c))
+STATS_CALL (R_geodesic_seq_range, P1, A1, stats_pairs_seq (a))
+STATS_CALL (R_geodesic_seq_stream, P0, A0, 0.0)
+STATS_CALL (R_geodesic_seq_vec, P3, A3, stats_pairs_seq_vec (a))
+STATS_CALL (R_geodesic_sparse, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_vec, P3, A3, stats_pairs_x_vec (a))
+STATS_CALL (R_geodesic_within, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_xy, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_xy_azimuth, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_xy_min, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_xy_range, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_geodesic_xy_vec, P5, A5, stats_pairs_xy_vec (a, c))
+STATS_CALL (R_haversine, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_haversine_async, P3, A3, 0.0)
+STATS_CALL (R_haversine_dist, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_haversine_file_min, P4, A4, stats_pairs_file_xy (a, b))
+STATS_CALL (R_haversine_file_paired, P4, A4, stats_pairs_file_paired (a))
+STATS_CALL (R_haversine_file_seq, P3, A3, stats_pairs_file_seq (a))
+STATS_CALL (R_haversine_file_range, P2, A2, stats_pairs_file_seq (a))
+STATS_CALL (R_haversine_knn, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_paired, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_haversine_paired_vec, P5, A5, stats_pairs_paired_vec (a))
+STATS_CALL (R_haversine_prepare, P1, A1, 0.0)
+STATS_CALL (R_haversine_range, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_haversine_range_bounds, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_haversine_reduce, P6, A6, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_seq, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_haversine_seq_groups, P5, A5, stats_pairs_groups (a, b, c))
+STATS_CALL (R_haversine_seq_range, P1, A1, stats_pairs_seq (a))
+STATS_CALL (R_haversine_seq_stream, P0, A0, 0.0)
+STATS_CALL (R_haversine_seq_vec, P3, A3, stats_pairs_seq_vec (a))
+STATS_CALL (R_haversine_single, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_sparse, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_vec, P3, A3, stats_pairs_x_vec (a))
+STATS_CALL (R_haversine_within, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_xy, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_xy_min, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_xy_range, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_haversine_xy_vec, P5, A5, stats_pairs_xy_vec (a, c))
+STATS_CALL (R_prepared_knn, P3, A3, stats_pairs_prepared (a, b))
+STATS_CALL (R_prepared_within, P3, A3, stats_pairs_prepared (a, b))
+STATS_CALL (R_prepared_xy, P3, A3, stats_pairs_prepared (a, b))
+STATS_CALL (R_prepared_xy_min, P3, A3, stats_pairs_prepared (a, b))
+STATS_CALL (R_prepared_xy_range, P3, A3, stats_pairs_prepared (a, b))
+STATS_CALL (R_ruler, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_ruler_async, P3, A3, 0.0)
+STATS_CALL (R_ruler_dist, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_ruler_file_min, P4, A4, stats_pairs_file_xy (a, b))
+STATS_CALL (R_ruler_file_paired, P4, A4, stats_pairs_file_paired (a))
+STATS_CALL (R_ruler_file_range, P2, A2, stats_pairs_file_seq (a))
+STATS_CALL (R_ruler_file_seq, P3, A3, stats_pairs_file_seq (a))
+STATS_CALL (R_ruler_paired, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_ruler_paired_vec, P5, A5, stats_pairs_paired_vec (a))
+STATS_CALL (R_ruler_range, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_ruler_reduce, P6, A6, stats_pairs_xy (a, b))
+STATS_CALL (R_ruler_seq, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_ruler_seq_range, P1, A1, stats_pairs_seq (a))
+STATS_CALL (R_ruler_seq_vec, P3, A3, stats_pairs_seq_vec (a))
+STATS_CALL (R_ruler_vec, P3, A3, stats_pairs_x_vec (a))
+STATS_CALL (R_ruler_xy, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_ruler_xy_min, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_ruler_xy_range, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_ruler_xy_vec, P5, A5, stats_pairs_xy_vec (a, c))
+STATS_CALL (R_seq_stream_append, P4, A4, stats_pairs_paired (b))
+STATS_CALL (R_seq_stream_stats, P1, A1, 0.0)
+STATS_CALL (R_vincenty, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_vincenty_async, P3, A3, 0.0)
+STATS_CALL (R_vincenty_dist, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_vincenty_file_min, P4, A4, stats_pairs_file_xy (a, b))
+STATS_CALL (R_vincenty_file_paired, P4, A4, stats_pairs_file_paired (a))
+STATS_CALL (R_vincenty_file_seq, P3, A3, stats_pairs_file_seq (a))
+STATS_CALL (R_vincenty_file_range, P2, A2, stats_pairs_file_seq (a))
+STATS_CALL (R_vincenty_knn, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_paired, P3, A3, stats_pairs_paired (a))
+STATS_CALL (R_vincenty_paired_vec, P5, A5, stats_pairs_paired_vec (a))
+STATS_CALL (R_vincenty_prepare, P1, A1, 0.0)
+STATS_CALL (R_vincenty_range, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_vincenty_range_bounds, P2, A2, stats_pairs_x (a))
+STATS_CALL (R_vincenty_reduce, P6, A6, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_seq, P2, A2, stats_pairs_seq (a))
+STATS_CALL (R_vincenty_seq_groups, P5, A5, stats_pairs_groups (a, b, c))
+STATS_CALL (R_vincenty_seq_range, P1, A1, stats_pairs_seq (a))
+STATS_CALL (R_vincenty_seq_stream, P0, A0, 0.0)
+STATS_CALL (R_vincenty_seq_vec, P3, A3, stats_pairs_seq_vec (a))
+STATS_CALL (R_vincenty_sparse, P4, A4, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_vec, P3, A3, stats_pairs_x_vec (a))
+STATS_CALL (R_vincenty_within, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_xy, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_xy_min, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_xy_range, P3, A3, stats_pairs_xy (a, b))
+STATS_CALL (R_vincenty_xy_vec, P5, A5, stats_pairs_xy_vec (a, c))
 
 static const R_CallMethodDef CallEntries[] = {
-    {"R_cheap",                (DL_FUNC) &R_cheap,                1},
-    {"R_cheap_paired",         (DL_FUNC) &R_cheap_paired,         2},
-    {"R_cheap_paired_vec",     (DL_FUNC) &R_cheap_paired_vec,     4},
-    {"R_cheap_range",          (DL_FUNC) &R_cheap_range,          1},
-    {"R_cheap_seq",            (DL_FUNC) &R_cheap_seq,            1},
-    {"R_cheap_seq_range",      (DL_FUNC) &R_cheap_seq_range,      1},
-    {"R_cheap_seq_vec",        (DL_FUNC) &R_cheap_seq_vec,        2},
-    {"R_cheap_vec",            (DL_FUNC) &R_cheap_vec,            2},
-    {"R_cheap_xy",             (DL_FUNC) &R_cheap_xy,             2},
-    {"R_cheap_xy_min",         (DL_FUNC) &R_cheap_xy_min,         2},
-    {"R_cheap_xy_range",       (DL_FUNC) &R_cheap_xy_range,       2},
-    {"R_cheap_xy_vec",         (DL_FUNC) &R_cheap_xy_vec,         4},
-    {"R_geodesic",             (DL_FUNC) &R_geodesic,             1},
-    {"R_geodesic_paired",      (DL_FUNC) &R_geodesic_paired,      2},
-    {"R_geodesic_paired_vec",  (DL_FUNC) &R_geodesic_paired_vec,  4},
-    {"R_geodesic_range",       (DL_FUNC) &R_geodesic_range,       1},
-    {"R_geodesic_seq",         (DL_FUNC) &R_geodesic_seq,         1},
-    {"R_geodesic_seq_range",   (DL_FUNC) &R_geodesic_seq_range,   1},
-    {"R_geodesic_seq_vec",     (DL_FUNC) &R_geodesic_seq_vec,     2},
-    {"R_geodesic_vec",         (DL_FUNC) &R_geodesic_vec,         2},
-    {"R_geodesic_xy",          (DL_FUNC) &R_geodesic_xy,          2},
-    {"R_geodesic_xy_min",      (DL_FUNC) &R_geodesic_xy_min,      2},
-    {"R_geodesic_xy_range",    (DL_FUNC) &R_geodesic_xy_range,    2},
-    {"R_geodesic_xy_vec",      (DL_FUNC) &R_geodesic_xy_vec,      4},
-    {"R_haversine",            (DL_FUNC) &R_haversine,            1},
-    {"R_haversine_paired",     (DL_FUNC) &R_haversine_paired,     2},
-    {"R_haversine_paired_vec", (DL_FUNC) &R_haversine_paired_vec, 4},
-    {"R_haversine_range",      (DL_FUNC) &R_haversine_range,      1},
-    {"R_haversine_seq",        (DL_FUNC) &R_haversine_seq,        1},
-    {"R_haversine_seq_range",  (DL_FUNC) &R_haversine_seq_range,  1},
-    {"R_haversine_seq_vec",    (DL_FUNC) &R_haversine_seq_vec,    2},
-    {"R_haversine_vec",        (DL_FUNC) &R_haversine_vec,        2},
-    {"R_haversine_xy",         (DL_FUNC) &R_haversine_xy,         2},
-    {"R_haversine_xy_min",     (DL_FUNC) &R_haversine_xy_min,     2},
-    {"R_haversine_xy_range",   (DL_FUNC) &R_haversine_xy_range,   2},
-    {"R_haversine_xy_vec",     (DL_FUNC) &R_haversine_xy_vec,     4},
-    {"R_vincenty",             (DL_FUNC) &R_vincenty,             1},
-    {"R_vincenty_paired",      (DL_FUNC) &R_vincenty_paired,      2},
-    {"R_vincenty_paired_vec",  (DL_FUNC) &R_vincenty_paired_vec,  4},
-    {"R_vincenty_range",       (DL_FUNC) &R_vincenty_range,       1},
-    {"R_vincenty_seq",         (DL_FUNC) &R_vincenty_seq,         1},
-    {"R_vincenty_seq_range",   (DL_FUNC) &R_vincenty_seq_range,   1},
-    {"R_vincenty_seq_vec",     (DL_FUNC) &R_vincenty_seq_vec,     2},
-    {"R_vincenty_vec",         (DL_FUNC) &R_vincenty_vec,         2},
-    {"R_vincenty_xy",          (DL_FUNC) &R_vincenty_xy,          2},
-    {"R_vincenty_xy_min",      (DL_FUNC) &R_vincenty_xy_min,      2},
-    {"R_vincenty_xy_range",    (DL_FUNC) &R_vincenty_xy_range,    2},
-    {"R_vincenty_xy_vec",      (DL_FUNC) &R_vincenty_xy_vec,      4},
+    {"R_async_cancel",         (DL_FUNC) &S_R_async_cancel,         1},
+    {"R_async_result",         (DL_FUNC) &S_R_async_result,         1},
+    {"R_async_status",         (DL_FUNC) &S_R_async_status,         1},
+    {"R_auto",                 (DL_FUNC) &S_R_auto,                 3},
+    {"R_auto_paired",          (DL_FUNC) &S_R_auto_paired,          4},
+    {"R_auto_paired_vec",      (DL_FUNC) &S_R_auto_paired_vec,      6},
+    {"R_auto_seq",             (DL_FUNC) &S_R_auto_seq,             3},
+    {"R_auto_seq_vec",         (DL_FUNC) &S_R_auto_seq_vec,         4},
+    {"R_auto_vec",             (DL_FUNC) &S_R_auto_vec,             4},
+    {"R_auto_xy",              (DL_FUNC) &S_R_auto_xy,              4},
+    {"R_auto_xy_vec",          (DL_FUNC) &S_R_auto_xy_vec,          6},
+    {"R_batch_vectorised",     (DL_FUNC) &R_batch_vectorised,       0},
+    {"R_cheap",                (DL_FUNC) &S_R_cheap,                2},
+    {"R_cheap_async",          (DL_FUNC) &S_R_cheap_async,          3},
+    {"R_cheap_dist",           (DL_FUNC) &S_R_cheap_dist,           2},
+    {"R_cheap_file_min",       (DL_FUNC) &S_R_cheap_file_min,       4},
+    {"R_cheap_file_paired",    (DL_FUNC) &S_R_cheap_file_paired,    4},
+    {"R_cheap_file_seq",       (DL_FUNC) &S_R_cheap_file_seq,       3},
+    {"R_cheap_file_range",     (DL_FUNC) &S_R_cheap_file_range,     2},
+    {"R_cheap_knn",            (DL_FUNC) &S_R_cheap_knn,            3},
+    {"R_cheap_paired",         (DL_FUNC) &S_R_cheap_paired,         3},
+    {"R_cheap_paired_vec",     (DL_FUNC) &S_R_cheap_paired_vec,     5},
+    {"R_cheap_prepare",        (DL_FUNC) &S_R_cheap_prepare,        1},
+    {"R_cheap_range",          (DL_FUNC) &S_R_cheap_range,          2},
+    {"R_cheap_range_bounds",   (DL_FUNC) &S_R_cheap_range_bounds,   2},
+    {"R_cheap_reduce",         (DL_FUNC) &S_R_cheap_reduce,         6},
+    {"R_cheap_seq",            (DL_FUNC) &S_R_cheap_seq,            2},
+    {"R_cheap_seq_groups",     (DL_FUNC) &S_R_cheap_seq_groups,     5},
+    {"R_cheap_seq_range",      (DL_FUNC) &S_R_cheap_seq_range,      1},
+    {"R_cheap_seq_stream",     (DL_FUNC) &S_R_cheap_seq_stream,     0},
+    {"R_cheap_seq_vec",        (DL_FUNC) &S_R_cheap_seq_vec,        3},
+    {"R_cheap_single",         (DL_FUNC) &S_R_cheap_single,         3},
+    {"R_cheap_sparse",         (DL_FUNC) &S_R_cheap_sparse,         4},
+    {"R_cheap_vec",            (DL_FUNC) &S_R_cheap_vec,            3},
+    {"R_cheap_within",         (DL_FUNC) &S_R_cheap_within,         3},
+    {"R_cheap_xy",             (DL_FUNC) &S_R_cheap_xy,             3},
+    {"R_cheap_xy_chunk",       (DL_FUNC) &S_R_cheap_xy_chunk,       4},
+    {"R_cheap_xy_min",         (DL_FUNC) &S_R_cheap_xy_min,         3},
+    {"R_cheap_xy_range",       (DL_FUNC) &S_R_cheap_xy_range,       3},
+    {"R_cheap_xy_vec",         (DL_FUNC) &S_R_cheap_xy_vec,         5},
+    {"R_geodesic",             (DL_FUNC) &S_R_geodesic,             2},
+    {"R_geodesic_async",       (DL_FUNC) &S_R_geodesic_async,       3},
+    {"R_geodesic_dist",        (DL_FUNC) &S_R_geodesic_dist,        2},
+    {"R_geodesic_file_min",    (DL_FUNC) &S_R_geodesic_file_min,    4},
+    {"R_geodesic_file_paired", (DL_FUNC) &S_R_geodesic_file_paired, 4},
+    {"R_geodesic_file_seq",    (DL_FUNC) &S_R_geodesic_file_seq,    3},
+    {"R_geodesic_file_range",  (DL_FUNC) &S_R_geodesic_file_range,  2},
+    {"R_geodesic_knn",         (DL_FUNC) &S_R_geodesic_knn,         3},
+    {"R_geodesic_paired",      (DL_FUNC) &S_R_geodesic_paired,      3},
+    {"R_geodesic_paired_azimuth", (DL_FUNC) &S_R_geodesic_paired_azimuth, 3},
+    {"R_geodesic_paired_vec",  (DL_FUNC) &S_R_geodesic_paired_vec,  5},
+    {"R_geodesic_prepare",     (DL_FUNC) &S_R_geodesic_prepare,     1},
+    {"R_geodesic_range",       (DL_FUNC) &S_R_geodesic_range,       2},
+    {"R_geodesic_range_bounds", (DL_FUNC) &S_R_geodesic_range_bounds, 2},
+    {"R_geodesic_reduce",      (DL_FUNC) &S_R_geodesic_reduce,      6},
+    {"R_geodesic_seq",         (DL_FUNC) &S_R_geodesic_seq,         2},
+    {"R_geodesic_seq_azimuth", (DL_FUNC) &S_R_geodesic_seq_azimuth, 2},
+    {"R_geodesic_seq_groups",  (DL_FUNC) &S_R_geodesic_seq_groups,  5},
+    {"R_geodesic_seq_range",   (DL_FUNC) &S_R_geodesic_seq_range,   1},
+    {"R_geodesic_seq_stream",  (DL_FUNC) &S_R_geodesic_seq_stream,  0},
+    {"R_geodesic_seq_vec",     (DL_FUNC) &S_R_geodesic_seq_vec,     3},
+    {"R_geodesic_sparse",      (DL_FUNC) &S_R_geodesic_sparse,      4},
+    {"R_geodesic_vec",         (DL_FUNC) &S_R_geodesic_vec,         3},
+    {"R_geodesic_within",      (DL_FUNC) &S_R_geodesic_within,      3},
+    {"R_geodesic_xy",          (DL_FUNC) &S_R_geodesic_xy,          3},
+    {"R_geodesic_xy_azimuth",  (DL_FUNC) &S_R_geodesic_xy_azimuth,  3},
+    {"R_geodesic_xy_min",      (DL_FUNC) &S_R_geodesic_xy_min,      3},
+    {"R_geodesic_xy_range",    (DL_FUNC) &S_R_geodesic_xy_range,    3},
+    {"R_geodesic_xy_vec",      (DL_FUNC) &S_R_geodesic_xy_vec,      5},
+    {"R_haversine",            (DL_FUNC) &S_R_haversine,            2},
+    {"R_haversine_async",      (DL_FUNC) &S_R_haversine_async,      3},
+    {"R_haversine_dist",       (DL_FUNC) &S_R_haversine_dist,       2},
+    {"R_haversine_file_min",   (DL_FUNC) &S_R_haversine_file_min,   4},
+    {"R_haversine_file_paired", (DL_FUNC) &S_R_haversine_file_paired, 4},
+    {"R_haversine_file_seq",   (DL_FUNC) &S_R_haversine_file_seq,   3},
+    {"R_haversine_file_range", (DL_FUNC) &S_R_haversine_file_range, 2},
+    {"R_haversine_knn",        (DL_FUNC) &S_R_haversine_knn,        3},
+    {"R_haversine_paired",     (DL_FUNC) &S_R_haversine_paired,     3},
+    {"R_haversine_paired_vec", (DL_FUNC) &S_R_haversine_paired_vec, 5},
+    {"R_haversine_prepare",    (DL_FUNC) &S_R_haversine_prepare,    1},
+    {"R_haversine_range",      (DL_FUNC) &S_R_haversine_range,      2},
+    {"R_haversine_range_bounds", (DL_FUNC) &S_R_haversine_range_bounds, 2},
+    {"R_haversine_reduce",     (DL_FUNC) &S_R_haversine_reduce,     6},
+    {"R_haversine_seq",        (DL_FUNC) &S_R_haversine_seq,        2},
+    {"R_haversine_seq_groups", (DL_FUNC) &S_R_haversine_seq_groups, 5},
+    {"R_haversine_seq_range",  (DL_FUNC) &S_R_haversine_seq_range,  1},
+    {"R_haversine_seq_stream", (DL_FUNC) &S_R_haversine_seq_stream, 0},
+    {"R_haversine_seq_vec",    (DL_FUNC) &S_R_haversine_seq_vec,    3},
+    {"R_haversine_single",     (DL_FUNC) &S_R_haversine_single,     3},
+    {"R_haversine_sparse",     (DL_FUNC) &S_R_haversine_sparse,     4},
+    {"R_haversine_vec",        (DL_FUNC) &S_R_haversine_vec,        3},
+    {"R_haversine_within",     (DL_FUNC) &S_R_haversine_within,     3},
+    {"R_haversine_xy",         (DL_FUNC) &S_R_haversine_xy,         3},
+    {"R_haversine_xy_min",     (DL_FUNC) &S_R_haversine_xy_min,     3},
+    {"R_haversine_xy_range",   (DL_FUNC) &S_R_haversine_xy_range,   3},
+    {"R_haversine_xy_vec",     (DL_FUNC) &S_R_haversine_xy_vec,     5},
+    {"R_prepared_knn",         (DL_FUNC) &S_R_prepared_knn,         3},
+    {"R_prepared_within",      (DL_FUNC) &S_R_prepared_within,      3},
+    {"R_prepared_xy",          (DL_FUNC) &S_R_prepared_xy,          3},
+    {"R_prepared_xy_min",      (DL_FUNC) &S_R_prepared_xy_min,      3},
+    {"R_prepared_xy_range",    (DL_FUNC) &S_R_prepared_xy_range,    3},
+    {"R_ruler",                (DL_FUNC) &S_R_ruler,                2},
+    {"R_ruler_async",          (DL_FUNC) &S_R_ruler_async,          3},
+    {"R_ruler_dist",           (DL_FUNC) &S_R_ruler_dist,           2},
+    {"R_ruler_file_min",       (DL_FUNC) &S_R_ruler_file_min,       4},
+    {"R_ruler_file_paired",    (DL_FUNC) &S_R_ruler_file_paired,    4},
+    {"R_ruler_file_range",     (DL_FUNC) &S_R_ruler_file_range,     2},
+    {"R_ruler_file_seq",       (DL_FUNC) &S_R_ruler_file_seq,       3},
+    {"R_ruler_paired",         (DL_FUNC) &S_R_ruler_paired,         3},
+    {"R_ruler_paired_vec",     (DL_FUNC) &S_R_ruler_paired_vec,     5},
+    {"R_ruler_range",          (DL_FUNC) &S_R_ruler_range,          2},
+    {"R_ruler_reduce",         (DL_FUNC) &S_R_ruler_reduce,         6},
+    {"R_ruler_seq",            (DL_FUNC) &S_R_ruler_seq,            2},
+    {"R_ruler_seq_range",      (DL_FUNC) &S_R_ruler_seq_range,      1},
+    {"R_ruler_seq_vec",        (DL_FUNC) &S_R_ruler_seq_vec,        3},
+    {"R_ruler_vec",            (DL_FUNC) &S_R_ruler_vec,            3},
+    {"R_ruler_xy",             (DL_FUNC) &S_R_ruler_xy,             3},
+    {"R_ruler_xy_min",         (DL_FUNC) &S_R_ruler_xy_min,         3},
+    {"R_ruler_xy_range",       (DL_FUNC) &S_R_ruler_xy_range,       3},
+    {"R_ruler_xy_vec",         (DL_FUNC) &S_R_ruler_xy_vec,         5},
+    {"R_seq_stream_append",    (DL_FUNC) &S_R_seq_stream_append,    4},
+    {"R_seq_stream_stats",     (DL_FUNC) &S_R_seq_stream_stats,     1},
+    {"R_stats",                (DL_FUNC) &R_stats,                  2},
+    {"R_vincenty",             (DL_FUNC) &S_R_vincenty,             2},
+    {"R_vincenty_async",       (DL_FUNC) &S_R_vincenty_async,       3},
+    {"R_vincenty_dist",        (DL_FUNC) &S_R_vincenty_dist,        2},
+    {"R_vincenty_file_min",    (DL_FUNC) &S_R_vincenty_file_min,    4},
+    {"R_vincenty_file_paired", (DL_FUNC) &S_R_vincenty_file_paired, 4},
+    {"R_vincenty_file_seq",    (DL_FUNC) &S_R_vincenty_file_seq,    3},
+    {"R_vincenty_file_range",  (DL_FUNC) &S_R_vincenty_file_range,  2},
+    {"R_vincenty_knn",         (DL_FUNC) &S_R_vincenty_knn,         3},
+    {"R_vincenty_paired",      (DL_FUNC) &S_R_vincenty_paired,      3},
+    {"R_vincenty_paired_vec",  (DL_FUNC) &S_R_vincenty_paired_vec,  5},
+    {"R_vincenty_prepare",     (DL_FUNC) &S_R_vincenty_prepare,     1},
+    {"R_vincenty_range",       (DL_FUNC) &S_R_vincenty_range,       2},
+    {"R_vincenty_range_bounds", (DL_FUNC) &S_R_vincenty_range_bounds, 2},
+    {"R_vincenty_reduce",      (DL_FUNC) &S_R_vincenty_reduce,      6},
+    {"R_vincenty_seq",         (DL_FUNC) &S_R_vincenty_seq,         2},
+    {"R_vincenty_seq_groups",  (DL_FUNC) &S_R_vincenty_seq_groups,  5},
+    {"R_vincenty_seq_range",   (DL_FUNC) &S_R_vincenty_seq_range,   1},
+    {"R_vincenty_seq_stream",  (DL_FUNC) &S_R_vincenty_seq_stream,  0},
+    {"R_vincenty_seq_vec",     (DL_FUNC) &S_R_vincenty_seq_vec,     3},
+    {"R_vincenty_sparse",      (DL_FUNC) &S_R_vincenty_sparse,      4},
+    {"R_vincenty_vec",         (DL_FUNC) &S_R_vincenty_vec,         3},
+    {"R_vincenty_within",      (DL_FUNC) &S_R_vincenty_within,      3},
+    {"R_vincenty_xy",          (DL_FUNC) &S_R_vincenty_xy,          3},
+    {"R_vincenty_xy_min",      (DL_FUNC) &S_R_vincenty_xy_min,      3},
+    {"R_vincenty_xy_range",    (DL_FUNC) &S_R_vincenty_xy_range,    3},
+    {"R_vincenty_xy_vec",      (DL_FUNC) &S_R_vincenty_xy_vec,      5},
     {NULL, NULL, 0}
 };
 
@@ -113,4 +499,6 @@ void R_init_geodist(DllInfo *dll)
 {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    geodesic_init();
+    ruler_init();
 }
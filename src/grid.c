@@ -0,0 +1,350 @@
+#include <string.h>
+
+#include "grid.h"
+
+// Search radii are inflated by these tolerances, as for kd-trees, so that
+// pairs are never lost to rounding at the boundaries of cells. Absolute
+// values are in degrees.
+#define GRID_REL_TOL 1.0e-9
+#define GRID_ABS_TOL 1.0e-12
+
+typedef struct
+{
+    uint64_t key;
+    size_t i;
+} grid_pt;
+
+static int grid_pt_cmp (const void *a, const void *b)
+{
+    const grid_pt *pa = (const grid_pt *) a, *pb = (const grid_pt *) b;
+    if (pa->key != pb->key)
+        return (pa->key > pb->key) - (pa->key < pb->key);
+    return (pa->i > pb->i) - (pa->i < pb->i);
+}
+
+static inline uint64_t grid_key (size_t row, size_t col)
+{
+    return ((uint64_t) row << 32) | (uint64_t) col;
+}
+
+static size_t grid_row (const nn_grid *g, double lat)
+{
+    double r = floor ((lat + 90.0) / g->dlat);
+    if (!(r > 0.0))
+        return 0;
+    if (r >= (double) g->nrows)
+        return g->nrows - 1;
+    return (size_t) r;
+}
+
+//' Longitude range of a spherical cap
+//'
+//' @param theta Angular radius of the cap in degrees
+//' @param lat Latitude of the centre of the cap in degrees
+//' @return Maximal difference in longitude in degrees between the centre and
+//' any point of the cap, or a negative value where the cap contains a pole,
+//' and so spans all longitudes.
+//' @noRd
+static double grid_cap_dlon (double theta, double lat)
+{
+    double phi = fabs (lat);
+    if (phi + theta >= 90.0)
+        return -1.0;
+    double s = sin (theta * M_PI / 180.0) / cos (phi * M_PI / 180.0);
+    return (s >= 1.0) ? -1.0 : asin (s) * 180.0 / M_PI;
+}
+
+//' Number of columns of one row
+//'
+//' Spherical columns are as wide as the longitude range of one search radius
+//' at the poleward edge of the row, and so span the full range of any query
+//' point in the row in no more than three columns.
+//' @noRd
+static size_t grid_ncols (const nn_grid *g, size_t row)
+{
+    if (g->measure == MEASURE_CHEAP)
+        return g->ncols;
+
+    double lat0 = -90.0 + (double) row * g->dlat;
+    double phi = fmax (fabs (lat0), fabs (lat0 + g->dlat));
+    double w = grid_cap_dlon (g->lat_radius, (phi > 90.0) ? 90.0 : phi);
+    if (w <= 0.0)
+        return 1;
+
+    double nc = floor (360.0 / w);
+    if (nc < 1.0)
+        return 1;
+    return (nc > GRID_MAX_DIM) ? GRID_MAX_DIM : (size_t) nc;
+}
+
+//' Column of a longitude within a row of ncols columns
+//'
+//' Spherical columns divide [0, 360), so that longitudes in [-180, 0) share
+//' the cells of the same longitudes in [180, 360).
+//' @noRd
+static size_t grid_col (const nn_grid *g, size_t ncols, double lon)
+{
+    double c;
+    if (g->measure == MEASURE_CHEAP)
+        c = floor ((lon - g->lon0) / g->lon_width);
+    else
+    {
+        if (lon < 0.0)
+            lon += 360.0;
+        else if (lon >= 360.0)
+            lon -= 360.0;
+        c = floor (lon * (double) ncols / 360.0);
+    }
+    if (!(c > 0.0))
+        return 0;
+    if (c >= (double) ncols)
+        return ncols - 1;
+    return (size_t) c;
+}
+
+//' Key of the cell of a point
+//' @noRd
+static uint64_t grid_point_key (const nn_grid *g, double lon, double lat)
+{
+    size_t row = grid_row (g, lat);
+    return grid_key (row, grid_col (g, grid_ncols (g, row), lon));
+}
+
+//' Build a grid over a set of points for searches within a single radius
+//'
+//' Points with non-finite coordinates are skipped, and so are never
+//' neighbours. Points are sorted by cell, and then by index, so that grids
+//' are identical for any input order of cells.
+//'
+//' @param radius Maximal distance in metres of all searches of the grid
+//' @param cosy Constant cosine multiplier of cheap distances; ignored for
+//' other measures.
+//' @param g All arrays are allocated with R_alloc. Must be called from the
+//' master thread only.
+//' @noRd
+void nn_grid_init (measure_t measure, const double *lon, const double *lat,
+        size_t n, double radius, double cosy, nn_grid *g)
+{
+    g->measure = measure;
+    g->cosy = cosy;
+    g->simd = batch_enabled ();
+
+    if (measure == MEASURE_CHEAP)
+    {
+        g->lat_radius = radius * 180.0 / meridian;
+        g->lon_radius = (cosy > 0.0) ?
+            radius * 360.0 / (equator * cosy) : R_PosInf;
+        g->lon_radius = g->lon_radius * (1.0 + GRID_REL_TOL) + GRID_ABS_TOL;
+    } else
+    {
+        double theta = radius / earth;
+        if (measure == MEASURE_GEODESIC)
+            theta /= geodesic_sphere_ratio;
+        g->lat_radius = theta * 180.0 / M_PI;
+        g->lon_radius = 0.0;
+    }
+    g->lat_radius = g->lat_radius * (1.0 + GRID_REL_TOL) + GRID_ABS_TOL;
+
+    g->dlat = fmax (g->lat_radius, 180.0 / (double) (GRID_MAX_DIM - 1));
+    g->nrows = (g->dlat >= 180.0) ? 1 : (size_t) ceil (180.0 / g->dlat);
+
+    size_t m = 0;
+    double lonmin = R_PosInf, lonmax = R_NegInf;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!isfinite (lon [i]) || !isfinite (lat [i]))
+            continue;
+        m++;
+        lonmin = fmin (lonmin, lon [i]);
+        lonmax = fmax (lonmax, lon [i]);
+    }
+
+    g->lon0 = (m > 0) ? lonmin : 0.0;
+    g->lon_width = g->lon_radius;
+    g->ncols = 1;
+    if (measure == MEASURE_CHEAP && m > 0)
+    {
+        double span = lonmax - lonmin;
+        if (span / g->lon_width >= (double) (GRID_MAX_DIM - 1))
+            g->lon_width = span / (double) (GRID_MAX_DIM - 1);
+        g->ncols = (size_t) floor (span / g->lon_width) + 1;
+    }
+
+    grid_pt *pts = (grid_pt *) stats_alloc (m, sizeof (grid_pt));
+    m = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!isfinite (lon [i]) || !isfinite (lat [i]))
+            continue;
+        pts [m].key = grid_point_key (g, lon [i], lat [i]);
+        pts [m++].i = i;
+    }
+    qsort (pts, m, sizeof (grid_pt), grid_pt_cmp);
+
+    double *x = (double *) stats_alloc (m, sizeof (double));
+    double *y = (double *) stats_alloc (m, sizeof (double));
+    g->index = (size_t *) stats_alloc (m, sizeof (size_t));
+    g->ncells = 0;
+    for (size_t k = 0; k < m; k++)
+    {
+        x [k] = lon [pts [k].i];
+        y [k] = lat [pts [k].i];
+        g->index [k] = pts [k].i;
+        if (k == 0 || pts [k].key != pts [k - 1].key)
+            g->ncells++;
+    }
+
+    g->cells = (uint64_t *) stats_alloc (g->ncells, sizeof (uint64_t));
+    g->cell_start = (size_t *) stats_alloc (g->ncells + 1, sizeof (size_t));
+    size_t c = 0;
+    for (size_t k = 0; k < m; k++)
+    {
+        if (k == 0 || pts [k].key != pts [k - 1].key)
+        {
+            g->cells [c] = pts [k].key;
+            g->cell_start [c++] = k;
+        }
+    }
+    g->cell_start [g->ncells] = m;
+
+    point_tables_init (measure, x, y, m, &g->p);
+}
+
+//' Order of the finite points of p by the cells of the grid in which they lie
+//'
+//' @param n Number of points in the order.
+//' @return R_alloc-ed array of indices into p. Must be called from the master
+//' thread only.
+//' @noRd
+size_t * nn_grid_order (const nn_grid *g, const point_tables *p, size_t *n)
+{
+    grid_pt *pts = (grid_pt *) stats_alloc (p->n, sizeof (grid_pt));
+    size_t m = 0;
+    for (size_t i = 0; i < p->n; i++)
+    {
+        if (point_na (p, i))
+            continue;
+        pts [m].key = grid_point_key (g, p->x [i], p->y [i]);
+        pts [m++].i = i;
+    }
+    qsort (pts, m, sizeof (grid_pt), grid_pt_cmp);
+
+    size_t *order = (size_t *) stats_alloc (m, sizeof (size_t));
+    for (size_t k = 0; k < m; k++)
+        order [k] = pts [k].i;
+    *n = m;
+
+    return order;
+}
+
+//' Append all points of cells [key0, key1] within 'radius' of point i of p
+//'
+//' @return 0 if the array of matches could not grow, otherwise 1
+//' @noRd
+static int grid_scan (const nn_grid *g, const point_tables *p, size_t i,
+        uint64_t key0, uint64_t key1, double radius, nn_matches *res)
+{
+    size_t lo = 0, hi = g->ncells;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (g->cells [mid] < key0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (size_t c = lo; c < g->ncells && g->cells [c] <= key1; c++)
+    {
+        size_t k0 = g->cell_start [c], k1 = g->cell_start [c + 1];
+        stats_count ((double) (k1 - k0));
+        for (size_t k = k0; k < k1; k++)
+        {
+            nn_match m;
+            kernel_row (g->measure, p, i, &g->p, k, 1, g->cosy, g->simd,
+                    &m.d);
+            if (m.d > radius)
+                continue;
+            m.j = g->index [k];
+            if (!nn_matches_add (res, m))
+                return 0; // # nocov
+        }
+    }
+
+    return 1;
+}
+
+//' All points of a grid within 'radius' of point i of p
+//'
+//' Only the cells of the rows within one search radius of the point are
+//' compared, with the columns of each row spanning the longitude range of
+//' that radius, which is split in two where it crosses the dateline, and
+//' spans the whole row where it contains a pole. Distances are calculated
+//' with the same row kernels as full distance matrices, including the batch
+//' kernels of 'options (geodist.simd = TRUE)', from point tables of both sets
+//' of points, and so are identical to those of the full matrices.
+//'
+//' @param p Point tables of the query points, of the same measure as the
+//' grid.
+//' @param radius No greater than the radius of `nn_grid_init()`.
+//' @param res Matches are appended to this array, in order of increasing
+//' index.
+//' @return Number of neighbours found
+//' @noRd
+size_t nn_grid_within (const nn_grid *g, const point_tables *p, size_t i,
+        double radius, nn_matches *res)
+{
+    size_t n0 = res->n;
+
+    if (g->p.n == 0 || point_na (p, i))
+        return 0;
+
+    double x = p->x [i], y = p->y [i];
+    size_t row0 = grid_row (g, y - g->lat_radius);
+    size_t row1 = grid_row (g, y + g->lat_radius);
+    double dlon = (g->measure == MEASURE_CHEAP) ? g->lon_radius :
+        grid_cap_dlon (g->lat_radius, y);
+
+    for (size_t row = row0; row <= row1; row++)
+    {
+        size_t ncols = grid_ncols (g, row);
+        size_t c0 [2] = { 0, 0 }, c1 [2] = { ncols - 1, 0 };
+        int nranges = 1;
+
+        if (g->measure == MEASURE_CHEAP)
+        {
+            if (isfinite (dlon))
+            {
+                c0 [0] = grid_col (g, ncols, x - dlon);
+                c1 [0] = grid_col (g, ncols, x + dlon);
+            }
+        } else if (dlon >= 0.0 && dlon < 180.0 && ncols > 1)
+        {
+            double lon0 = x - dlon;
+            if (lon0 < 0.0)
+                lon0 += 360.0;
+            double lon1 = lon0 + 2.0 * dlon;
+            c0 [0] = grid_col (g, ncols, lon0);
+            if (lon1 < 360.0)
+                c1 [0] = grid_col (g, ncols, lon1);
+            else
+            {
+                // Range crosses the dateline, and is split in two:
+                c1 [1] = grid_col (g, ncols, lon1 - 360.0);
+                if (c1 [1] >= c0 [0])
+                    c0 [0] = 0;
+                else
+                    nranges = 2;
+            }
+        }
+
+        for (int r = 0; r < nranges; r++)
+            if (!grid_scan (g, p, i, grid_key (row, c0 [r]),
+                        grid_key (row, c1 [r]), radius, res))
+                return res->n - n0; // # nocov
+    }
+
+    nn_matches_sort (res, n0);
+
+    return res->n - n0;
+}
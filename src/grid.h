@@ -0,0 +1,57 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stdint.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "kernels.h"
+
+// Maximal numbers of rows, and of columns in each row, beyond which cells are
+// enlarged, so that cell keys always fit in 64 bits.
+#define GRID_MAX_DIM 1073741824
+
+// Latitude-longitude grid of one set of points, with cells sized to a single
+// search radius, so that all points within that radius of any query point lie
+// in the neighbouring cells only. Rows are bands of latitude, one search
+// radius high. For spherical measures, each row is divided into columns of
+// the longitude range of a search radius at the poleward edge of the row,
+// which widen with the cos(lat) shrinkage of meridians, and wrap around the
+// dateline. Rows which are within one radius of a pole have a single cell.
+// Cheap distances have no wrapping, and columns of constant width.
+//
+// Only occupied cells are stored, as sorted keys of (row, column), so that
+// memory scales with the number of points, and not with the radius. Points
+// are copied in the order of their cells, with all point tables of the
+// measure, so that points of each cell are contiguous.
+typedef struct
+{
+    measure_t measure;
+    double cosy; // constant cosine multiplier for cheap distances
+    int simd; // whether batch kernels are used; see `batch_enabled()`
+    point_tables p; // finite points, in order of cell
+    size_t *index; // original index of each point of p
+    uint64_t *cells; // sorted keys of occupied cells
+    size_t *cell_start; // first point of each cell, and p.n
+    size_t ncells;
+    size_t nrows;
+    double dlat; // height of rows in degrees
+    double lat_radius; // search radius in degrees of latitude, and the
+                       // angular search radius of spherical measures
+    double lon_radius; // search radius of cheap distances in degrees of
+                       // longitude
+    double lon0, lon_width; // origin and width of cheap columns
+    size_t ncols; // number of cheap columns
+} nn_grid;
+
+void nn_grid_init (measure_t measure, const double *lon, const double *lat,
+        size_t n, double radius, double cosy, nn_grid *g);
+size_t * nn_grid_order (const nn_grid *g, const point_tables *p, size_t *n);
+size_t nn_grid_within (const nn_grid *g, const point_tables *p, size_t i,
+        double radius, nn_matches *res);
+
+#endif /* GRID_H */
@@ -292,55 +292,82 @@ static int find_nearest(struct kdnode *node, const double *pos, double range, st
 	return added_res;
 }
 
-#if 0
-static int find_nearest_n(struct kdnode *node, const double *pos, double range, int num, struct rheap *heap, int dim)
+/* bounded max-heap of the N nearest nodes found so far */
+struct rheap {
+	struct res_node *nodes;
+	int size, capacity;
+};
+
+static void rheap_sift_down(struct rheap *heap, int i)
 {
-	double dist_sq, dx;
-	int i, ret, added_res = 0;
+	struct res_node tmp;
+	int largest, left, right;
 
-	if(!node) return 0;
-	
-	/* if the photon is close enough, add it to the result heap */
-	dist_sq = 0;
-	for(i=0; i<dim; i++) {
-		dist_sq += SQ(node->pos[i] - pos[i]);
+	for(;;) {
+		largest = i;
+		left = 2 * i + 1;
+		right = 2 * i + 2;
+		if(left < heap->size && heap->nodes[left].dist_sq > heap->nodes[largest].dist_sq) {
+			largest = left;
+		}
+		if(right < heap->size && heap->nodes[right].dist_sq > heap->nodes[largest].dist_sq) {
+			largest = right;
+		}
+		if(largest == i) break;
+		tmp = heap->nodes[i];
+		heap->nodes[i] = heap->nodes[largest];
+		heap->nodes[largest] = tmp;
+		i = largest;
+	}
+}
+
+static void rheap_insert(struct rheap *heap, struct kdnode *node, double dist_sq)
+{
+	struct res_node tmp;
+	int i, parent;
+
+	if(heap->size < heap->capacity) {
+		i = heap->size++;
+		heap->nodes[i].item = node;
+		heap->nodes[i].dist_sq = dist_sq;
+		while(i > 0) {
+			parent = (i - 1) / 2;
+			if(heap->nodes[parent].dist_sq >= heap->nodes[i].dist_sq) break;
+			tmp = heap->nodes[i];
+			heap->nodes[i] = heap->nodes[parent];
+			heap->nodes[parent] = tmp;
+			i = parent;
+		}
+	} else if(dist_sq < heap->nodes[0].dist_sq) {
+		/* replace the furthest element */
+		heap->nodes[0].item = node;
+		heap->nodes[0].dist_sq = dist_sq;
+		rheap_sift_down(heap, 0);
 	}
-	if(dist_sq <= range_sq) {
-		if(heap->size >= num) {
-			/* get furthest element */
-			struct res_node *maxelem = rheap_get_max(heap);
+}
 
-			/* and check if the new one is closer than that */
-			if(maxelem->dist_sq > dist_sq) {
-				rheap_remove_max(heap);
+static void find_nearest_n(struct kdnode *node, const double *pos, struct rheap *heap, int dim)
+{
+	double dist_sq, dx;
+	int i;
 
-				if(rheap_insert(heap, node, dist_sq) == -1) {
-					return -1;
-				}
-				added_res = 1;
+	if(!node) return;
 
-				range_sq = dist_sq;
-			}
-		} else {
-			if(rheap_insert(heap, node, dist_sq) == -1) {
-				return =1;
-			}
-			added_res = 1;
-		}
+	/* if the node is close enough, add it to the result heap */
+	dist_sq = 0;
+	for(i=0; i<dim; i++) {
+		dist_sq += SQ(node->pos[i] - pos[i]);
 	}
-
+	rheap_insert(heap, node, dist_sq);
 
 	/* find signed distance from the splitting plane */
 	dx = pos[node->dir] - node->pos[node->dir];
 
-	ret = find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, range, num, heap, dim);
-	if(ret >= 0 && fabs(dx) < range) {
-		added_res += ret;
-		ret = find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, range, num, heap, dim);
+	find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, heap, dim);
+	if(heap->size < heap->capacity || SQ(dx) < heap->nodes[0].dist_sq) {
+		find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, heap, dim);
 	}
-
 }
-#endif
 
 static void kd_nearest_i(struct kdnode *node, const double *pos, struct kdnode **result, double *result_dist_sq, struct kdhyperrect* rect)
 {
@@ -509,11 +536,13 @@ struct kdres *kd_nearest3f(struct kdtree *tree, float x, float y, float z)
 }
 
 /* ---- nearest N search ---- */
-/*
-static kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
+struct kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
 {
-	int ret;
 	struct kdres *rset;
+	struct rheap heap;
+	int i;
+
+	if(num < 1) return 0;
 
 	if(!(rset = malloc(sizeof *rset))) {
 		return 0;
@@ -525,14 +554,58 @@ static kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
 	rset->rlist->next = 0;
 	rset->tree = kd;
 
-	if((ret = find_nearest_n(kd->root, pos, range, num, rset->rlist, kd->dim)) == -1) {
+	heap.size = 0;
+	heap.capacity = num;
+	if(!(heap.nodes = malloc(num * sizeof *heap.nodes))) {
 		kd_res_free(rset);
 		return 0;
 	}
-	rset->size = ret;
+
+	find_nearest_n(kd->root, pos, &heap, kd->dim);
+
+	/* results are returned in order of increasing distance */
+	for(i=0; i<heap.size; i++) {
+		if(rlist_insert(rset->rlist, heap.nodes[i].item, heap.nodes[i].dist_sq) == -1) {
+			free(heap.nodes);
+			kd_res_free(rset);
+			return 0;
+		}
+	}
+	rset->size = heap.size;
+	free(heap.nodes);
 	kd_res_rewind(rset);
 	return rset;
-}*/
+}
+
+struct kdres *kd_nearest_nf(struct kdtree *tree, const float *pos, int num)
+{
+	double buf[16];
+	int i;
+
+	if(tree->dim > 16) return 0;
+	for(i=0; i<tree->dim; i++) {
+		buf[i] = pos[i];
+	}
+	return kd_nearest_n(tree, buf, num);
+}
+
+struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z, int num)
+{
+	double pos[3];
+	pos[0] = x;
+	pos[1] = y;
+	pos[2] = z;
+	return kd_nearest_n(tree, pos, num);
+}
+
+struct kdres *kd_nearest_n3f(struct kdtree *tree, float x, float y, float z, int num)
+{
+	double pos[3];
+	pos[0] = x;
+	pos[1] = y;
+	pos[2] = z;
+	return kd_nearest_n(tree, pos, num);
+}
 
 struct kdres *kd_nearest_range(struct kdtree *kd, const double *pos, double range)
 {
@@ -75,8 +75,8 @@ struct kdres *kd_nearest3f(struct kdtree *tree, float x, float y, float z);
  */
 struct kdres *kd_nearest_n(struct kdtree *tree, const double *pos, int num);
 struct kdres *kd_nearest_nf(struct kdtree *tree, const float *pos, int num);
-struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z);
-struct kdres *kd_nearest_n3f(struct kdtree *tree, float x, float y, float z);
+struct kdres *kd_nearest_n3(struct kdtree *tree, double x, double y, double z, int num);
+struct kdres *kd_nearest_n3f(struct kdtree *tree, float x, float y, float z, int num);
 
 /* Find any nearest nodes from a given point within a range.
  *
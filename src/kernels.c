@@ -0,0 +1,160 @@
+#include "kernels.h"
+
+//' Accumulate minimal and maximal values of d, ignoring NaN values
+//' @param range Current minimum and maximum, updated in place
+//' @noRd
+static void kernel_minmax (const double *d, size_t n, double *range)
+{
+    double min = range [0], max = range [1];
+    for (size_t i = 0; i < n; i++)
+    {
+        min = (d [i] < min) ? d [i] : min;
+        max = (d [i] > max) ? d [i] : max;
+    }
+    range [0] = min;
+    range [1] = max;
+}
+
+//' Minima and maxima of each of nthreads threads, initialised beyond the
+//' range of any distance
+//' @noRd
+static double * kernel_ranges (int nthreads)
+{
+    double *ranges = thread_slots (nthreads);
+    for (int t = 0; t < nthreads; t++)
+    {
+        ranges [THREAD_SLOT * t] = 100.0 * equator;
+        ranges [THREAD_SLOT * t + 1] = -100.0 * equator;
+    }
+    return ranges;
+}
+
+static void kernel_ranges_combine (const double *ranges, int nthreads,
+        double *range)
+{
+    range [0] = 100.0 * equator;
+    range [1] = -100.0 * equator;
+    for (int t = 0; t < nthreads; t++)
+    {
+        if (ranges [THREAD_SLOT * t] < range [0])
+            range [0] = ranges [THREAD_SLOT * t];
+        if (ranges [THREAD_SLOT * t + 1] > range [1])
+            range [1] = ranges [THREAD_SLOT * t + 1];
+    }
+}
+
+// One specialised set of traversals for each measure, each with pair
+// evaluation inlined, and no dispatch on measure within any loop.
+
+#define KERNEL_MEASURE haversine
+#define KERNEL_TILED 1
+#include "kernels_body.h"
+
+#define KERNEL_MEASURE vincenty
+#define KERNEL_TILED 1
+#include "kernels_body.h"
+
+#define KERNEL_MEASURE cheap
+#define KERNEL_TILED 1
+#include "kernels_body.h"
+
+#define KERNEL_MEASURE geodesic
+#define KERNEL_TILED 0
+#include "kernels_body.h"
+
+#define KERNEL_MEASURE ruler
+#define KERNEL_TILED 1
+#include "kernels_body.h"
+
+#define KERNEL_DISPATCH(name, ...) \
+    switch (measure) \
+    { \
+        case MEASURE_HAVERSINE: \
+            name ## _haversine (__VA_ARGS__); \
+            break; \
+        case MEASURE_VINCENTY: \
+            name ## _vincenty (__VA_ARGS__); \
+            break; \
+        case MEASURE_CHEAP: \
+            name ## _cheap (__VA_ARGS__); \
+            break; \
+        case MEASURE_GEODESIC: \
+            name ## _geodesic (__VA_ARGS__); \
+            break; \
+        case MEASURE_RULER: \
+            name ## _ruler (__VA_ARGS__); \
+            break; \
+    }
+
+//' Full or condensed distance matrix of one set of points
+//'
+//' All kernels here must be called from the master thread, and are
+//' parallelised internally where the traversal allows.
+//'
+//' @param p Points and per-point terms from `point_tables_init()`
+//' @param cosy Constant cosine multiplier for cheap distances
+//' @param condensed If 0, fill the full (n * n) matrix `rout`; otherwise the
+//' n * (n - 1) / 2 values of the upper triangle in row-major order.
+//' @noRd
+void kernel_tri_dists (measure_t measure, const point_tables *p, double cosy,
+        int condensed, int nthreads, double *rout)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (tri_dists, p, cosy, condensed, simd, nthreads, rout);
+}
+
+//' Full matrix of distances between two sets of points
+//'
+//' @param p1, p2 Points and per-point terms from `point_tables_init()`, or
+//' from prepared points.
+//' @param rout Matrix of (p1->n * p2->n) distances, with p2 varying fastest.
+//' @noRd
+void kernel_xy_dists (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *rout)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (xy_dists, p1, p2, cosy, simd, nthreads, rout);
+}
+
+//' Paired distances between two sets of points
+//'
+//' @param p1, p2 Points and per-point terms from `pair_tables_init()`; for
+//' sequential distances, p2 is p1 shifted by one point.
+//' @param rout Vector filled with the distances of the first
+//' min(p1->n, p2->n) pairs.
+//' @noRd
+void kernel_paired_dists (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *rout)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (paired_dists, p1, p2, cosy, simd, nthreads, rout);
+}
+
+//' Minimal and maximal distances between all pairs of one set of points
+//' @param range Filled with minimal and maximal distances.
+//' @noRd
+void kernel_tri_range (measure_t measure, const point_tables *p, double cosy,
+        int nthreads, double *range)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (tri_range, p, cosy, simd, nthreads, range);
+}
+
+//' Minimal and maximal distances between two sets of points
+//' @noRd
+void kernel_xy_range (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *range)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (xy_range, p1, p2, cosy, simd, nthreads, range);
+}
+
+//' Minimal and maximal distances between successive points
+//' @param p Points and per-point terms from `pair_tables_init()`
+//' @noRd
+void kernel_seq_range (measure_t measure, const point_tables *p, double cosy,
+        double *range)
+{
+    int simd = batch_enabled ();
+    KERNEL_DISPATCH (seq_range, p, cosy, simd, range);
+}
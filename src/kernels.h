@@ -0,0 +1,297 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stddef.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "threads.h"
+#include "tiles.h"
+#include "batch.h"
+
+// Distance evaluation for each measure, composed into all traversals of
+// kernels.c. Each takes point tables from `point_tables_init()` or
+// `pair_tables_init()`, of which only the terms needed by that measure are
+// read.
+
+// Squared chord length between two unit vectors of `unit_vectors()`, which
+// is monotonic in great circle distance
+static inline double chord2 (const double *u1, const double *u2)
+{
+    double dx = u1 [0] - u2 [0];
+    double dy = u1 [1] - u2 [1];
+    double dz = u1 [2] - u2 [2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Great circle distance of a squared chord length, which may exceed 4 by
+// rounding for antipodal points
+static inline double chord_dist (double c2)
+{
+    double s = 0.5 * sqrt (c2);
+    if (s > 1.0)
+        s = 1.0;
+    return 2.0 * earth * asin (s);
+}
+
+// Points marked as missing by `coords_validate()` have NA distances to all
+// other points. No distances of missing points of p1 are evaluated, while
+// those of p2 are overwritten after each row, so that row kernels remain free
+// of branches for complete coordinates.
+static inline int point_na (const point_tables *p, size_t i)
+{
+    return p->na != NULL && p->na [i];
+}
+
+static inline void na_fill (double *out, size_t n)
+{
+    for (size_t j = 0; j < n; j++)
+        out [j] = NA_REAL;
+}
+
+// Set NA for the missing points of p2 in [j0, j0 + n)
+static inline void na_mask_row (const point_tables *p2, size_t j0, size_t n,
+        double *out)
+{
+    if (p2->na == NULL)
+        return;
+    const unsigned char *na = p2->na + j0;
+    for (size_t j = 0; j < n; j++)
+        if (na [j])
+            out [j] = NA_REAL;
+}
+
+// Set NA for pairs [i0, i0 + n) in which either point is missing
+static inline void na_mask_pairs (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double *out)
+{
+    if (p1->na == NULL && p2->na == NULL)
+        return;
+    for (size_t i = 0; i < n; i++)
+        if (point_na (p1, i0 + i) || point_na (p2, i0 + i))
+            out [i] = NA_REAL;
+}
+
+// Haversine distances are calculated from unit vectors whenever both tables
+// hold them, with 'options (geodist.chord = TRUE)'.
+
+// Distance between point i of p1 and point j of p2
+static inline double pair_haversine (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, double cosy)
+{
+    if (p1->u && p2->u)
+        return chord_dist (chord2 (p1->u + 3 * i, p2->u + 3 * j));
+    return one_haversine (p1->x [i], p1->y [i], p2->x [j], p2->y [j],
+            p1->cosy [i], p2->cosy [j]);
+}
+
+static inline double pair_vincenty (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, double cosy)
+{
+    return one_vincenty (p1->x [i], p2->x [j], p1->siny [i], p1->cosy [i],
+            p2->siny [j], p2->cosy [j]);
+}
+
+static inline double pair_cheap (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, double cosy)
+{
+    return one_cheap (p1->x [i], p1->y [i], p2->x [j], p2->y [j], cosy);
+}
+
+static inline double pair_geodesic (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, double cosy)
+{
+    return one_geodesic_pts (p1->pts + i, p2->pts + j);
+}
+
+static inline double pair_ruler (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j, double cosy)
+{
+    return one_ruler (p1->x [i], p1->y [i], p2->x [j], p2->y [j]);
+}
+
+// Distances between point i of p1 and points [j0, j0 + n) of p2
+static inline void row_haversine (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (p1->u && p2->u)
+    {
+        const double *u1 = p1->u + 3 * i, *u2 = p2->u + 3 * j0;
+        for (size_t j = 0; j < n; j++)
+            out [j] = chord_dist (chord2 (u1, u2 + 3 * j));
+    } else if (simd)
+        batch_haversine_row (p1->x [i], p1->y [i], p1->cosy [i],
+                p2->x + j0, p2->y + j0, p2->cosy + j0, n, out);
+    else
+        for (size_t j = 0; j < n; j++)
+            out [j] = pair_haversine (p1, i, p2, j0 + j, cosy);
+}
+
+static inline void row_vincenty (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (simd)
+        batch_vincenty_row (p1->x [i], p1->siny [i], p1->cosy [i],
+                p2->x + j0, p2->siny + j0, p2->cosy + j0, n, out);
+    else
+        for (size_t j = 0; j < n; j++)
+            out [j] = pair_vincenty (p1, i, p2, j0 + j, cosy);
+}
+
+static inline void row_cheap (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (simd)
+        batch_cheap_row (p1->x [i], p1->y [i], p2->x + j0, p2->y + j0, cosy,
+                n, out);
+    else
+        for (size_t j = 0; j < n; j++)
+            out [j] = pair_cheap (p1, i, p2, j0 + j, cosy);
+}
+
+static inline void row_geodesic (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    geod_inverse_many (geodesic_wgs84 (), p1->pts + i, n, p2->pts + j0, out);
+}
+
+static inline void row_ruler (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    for (size_t j = 0; j < n; j++)
+        out [j] = pair_ruler (p1, i, p2, j0 + j, cosy);
+}
+
+// Distances between points [i0, i0 + n) of p1 and the same points of p2.
+// Each point is used only once, so geodesics are calculated directly from
+// coordinates, without the terms of `geodesic_points()`.
+static inline void pairs_haversine (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (simd)
+        batch_haversine_pairs (p1->x + i0, p1->y + i0, p1->cosy + i0,
+                p2->x + i0, p2->y + i0, p2->cosy + i0, n, out);
+    else
+        for (size_t i = 0; i < n; i++)
+            out [i] = pair_haversine (p1, i0 + i, p2, i0 + i, cosy);
+}
+
+static inline void pairs_vincenty (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (simd)
+        batch_vincenty_pairs (p1->x + i0, p1->siny + i0, p1->cosy + i0,
+                p2->x + i0, p2->siny + i0, p2->cosy + i0, n, out);
+    else
+        for (size_t i = 0; i < n; i++)
+            out [i] = pair_vincenty (p1, i0 + i, p2, i0 + i, cosy);
+}
+
+static inline void pairs_cheap (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (simd)
+        batch_cheap_pairs (p1->x + i0, p1->y + i0, p2->x + i0, p2->y + i0,
+                cosy, n, out);
+    else
+        for (size_t i = 0; i < n; i++)
+            out [i] = pair_cheap (p1, i0 + i, p2, i0 + i, cosy);
+}
+
+static inline void pairs_geodesic (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double cosy, int simd,
+        double *out)
+{
+    for (size_t i = i0; i < i0 + n; i++)
+        out [i - i0] = one_geodesic (p1->x [i], p1->y [i], p2->x [i],
+                p2->y [i]);
+}
+
+static inline void pairs_ruler (const point_tables *p1,
+        const point_tables *p2, size_t i0, size_t n, double cosy, int simd,
+        double *out)
+{
+    for (size_t i = 0; i < n; i++)
+        out [i] = pair_ruler (p1, i0 + i, p2, i0 + i, cosy);
+}
+
+//' Distance between point i of p1 and point j of p2, for traversals which
+//' select pairs individually rather than by rows
+//' @noRd
+static inline double kernel_pair (measure_t measure, const point_tables *p1,
+        size_t i, const point_tables *p2, size_t j, double cosy)
+{
+    switch (measure)
+    {
+        case MEASURE_HAVERSINE:
+            return pair_haversine (p1, i, p2, j, cosy);
+        case MEASURE_VINCENTY:
+            return pair_vincenty (p1, i, p2, j, cosy);
+        case MEASURE_CHEAP:
+            return pair_cheap (p1, i, p2, j, cosy);
+        case MEASURE_RULER:
+            return pair_ruler (p1, i, p2, j, cosy);
+        default:
+            return pair_geodesic (p1, i, p2, j, cosy);
+    }
+}
+
+//' Distances between point i of p1 and points [j0, j0 + n) of p2, for
+//' traversals outside of kernels.c, with NA for missing points
+//' @noRd
+static inline void kernel_row (measure_t measure, const point_tables *p1,
+        size_t i, const point_tables *p2, size_t j0, size_t n, double cosy,
+        int simd, double *out)
+{
+    if (point_na (p1, i))
+    {
+        na_fill (out, n);
+        return;
+    }
+
+    switch (measure)
+    {
+        case MEASURE_HAVERSINE:
+            row_haversine (p1, i, p2, j0, n, cosy, simd, out);
+            break;
+        case MEASURE_VINCENTY:
+            row_vincenty (p1, i, p2, j0, n, cosy, simd, out);
+            break;
+        case MEASURE_CHEAP:
+            row_cheap (p1, i, p2, j0, n, cosy, simd, out);
+            break;
+        case MEASURE_RULER:
+            row_ruler (p1, i, p2, j0, n, cosy, simd, out);
+            break;
+        default:
+            row_geodesic (p1, i, p2, j0, n, cosy, simd, out);
+    }
+    na_mask_row (p2, j0, n, out);
+}
+
+void kernel_tri_dists (measure_t measure, const point_tables *p, double cosy,
+        int condensed, int nthreads, double *rout);
+void kernel_xy_dists (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *rout);
+void kernel_paired_dists (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *rout);
+
+void kernel_tri_range (measure_t measure, const point_tables *p, double cosy,
+        int nthreads, double *range);
+void kernel_xy_range (measure_t measure, const point_tables *p1,
+        const point_tables *p2, double cosy, int nthreads, double *range);
+void kernel_seq_range (measure_t measure, const point_tables *p, double cosy,
+        double *range);
+
+#endif /* KERNELS_H */
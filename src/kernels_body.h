@@ -0,0 +1,272 @@
+// Traversals of pairs of points for one distance measure, included once for
+// each measure by kernels.c, with KERNEL_MEASURE defined as the suffix of the
+// `pair_`, `row_` and `pairs_` functions of kernels.h, and KERNEL_TILED as 1
+// for measures for which y is compared in cache-sized tiles, or 0 for
+// geodesics, which are expensive enough that tiling gains nothing.
+
+#define KERNEL_CAT2(a, b) a ## _ ## b
+#define KERNEL_CAT(a, b) KERNEL_CAT2 (a, b)
+#define KERNEL(name) KERNEL_CAT (name, KERNEL_MEASURE)
+
+//' Row kernel with NA for missing points of either table; see `point_na()`
+//' @noRd
+static inline void KERNEL (row_na) (const point_tables *p1, size_t i,
+        const point_tables *p2, size_t j0, size_t n, double cosy, int simd,
+        double *out)
+{
+    if (point_na (p1, i))
+        na_fill (out, n);
+    else
+    {
+        KERNEL (row) (p1, i, p2, j0, n, cosy, simd, out);
+        na_mask_row (p2, j0, n, out);
+    }
+}
+
+//' Full or condensed matrix of distances between all pairs of x
+//'
+//' Each row of the upper triangle is calculated in one pass, and copied to
+//' the lower triangle of full matrices.
+//'
+//' @param condensed If 0, fill the full (n * n) matrix; otherwise the
+//' n * (n - 1) / 2 values of the upper triangle in row-major order.
+//' @noRd
+static void KERNEL (tri_dists) (const point_tables *p, double cosy,
+        int condensed, int simd, int nthreads, double *rout)
+{
+    size_t n = p->n;
+
+    if (!condensed)
+        for (size_t i = 0; i < n; i++)
+            rout [i * n + i] = 0.0;
+
+    size_t nblocks;
+    size_t *blocks = tri_row_blocks (n, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            size_t nrow = n - i - 1;
+            double *row = condensed ? rout + i * n - i * (i + 1) / 2 :
+                rout + i * n + i + 1;
+            KERNEL (row_na) (p, i, p, i + 1, nrow, cosy, simd, row);
+            if (!condensed)
+                for (size_t j = (i + 1); j < n; j++)
+                    rout [j * n + i] = rout [i * n + j];
+        }
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Full matrix of (p1->n * p2->n) distances between x and y, with y varying
+//' fastest
+//'
+//' Each block of rows of x is compared against one tile of TILE_NY points of
+//' y at a time, read in place from the tables of y.
+//' @noRd
+static void KERNEL (xy_dists) (const point_tables *p1, const point_tables *p2,
+        double cosy, int simd, int nthreads, double *rout)
+{
+    size_t nx = p1->n, ny = p2->n;
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (nx, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+#if KERNEL_TILED
+        for (size_t j0 = 0; j0 < ny; j0 += TILE_NY)
+        {
+            size_t nb = (j0 + TILE_NY < ny) ? TILE_NY : ny - j0;
+            for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+                KERNEL (row_na) (p1, i, p2, j0, nb, cosy, simd,
+                        rout + i * ny + j0);
+        }
+#else
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+            KERNEL (row_na) (p1, i, p2, 0, ny, cosy, simd, rout + i * ny);
+#endif
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Paired distances between each point of p1 and the same point of p2, for
+//' as many points as the shorter of the two
+//'
+//' Closed-form measures have constant costs, and so blocks are scheduled
+//' statically, while those of geodesics vary with the separation of the
+//' points, and so are scheduled dynamically.
+//' @noRd
+static void KERNEL (paired_dists) (const point_tables *p1,
+        const point_tables *p2, double cosy, int simd, int nthreads,
+        double *rout)
+{
+    size_t n = (p1->n < p2->n) ? p1->n : p2->n;
+    size_t nblocks;
+    size_t *blocks = row_blocks (n, nthreads, &nblocks);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+#if KERNEL_TILED
+    #pragma omp parallel for num_threads (nthreads) schedule (static)
+#else
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        size_t i0 = blocks [b];
+        size_t n = blocks [b + 1] - i0;
+        KERNEL (pairs) (p1, p2, i0, n, cosy, simd, rout + i0);
+        na_mask_pairs (p1, p2, i0, n, rout + i0);
+    }
+    end_check_interrupt (interrupted);
+}
+
+//' Minimal and maximal distances between all pairs of x
+//'
+//' Rows of the upper triangle are passed in segments of TILE_NY pairs to the
+//' row kernels, and reduced into the minimum and maximum of each thread,
+//' which are only combined once the region has finished. Results are
+//' identical for any number of threads. Rows of missing points are skipped,
+//' and the NA distances to other missing points ignored by
+//' `kernel_minmax()`.
+//' @noRd
+static void KERNEL (tri_range) (const point_tables *p, double cosy, int simd,
+        int nthreads, double *range)
+{
+    size_t n = p->n;
+
+    size_t nblocks;
+    size_t *blocks = tri_row_blocks (n, nthreads, &nblocks);
+    double *ranges = kernel_ranges (nthreads);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        double *r = ranges + THREAD_SLOT * omp_get_thread_num ();
+        double row [TILE_NY];
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            if (point_na (p, i))
+                continue;
+            for (size_t j0 = i + 1; j0 < n; j0 += TILE_NY)
+            {
+                size_t nb = (j0 + TILE_NY < n) ? TILE_NY : n - j0;
+                KERNEL (row_na) (p, i, p, j0, nb, cosy, simd, row);
+                kernel_minmax (row, nb, r);
+            }
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    kernel_ranges_combine (ranges, nthreads, range);
+}
+
+//' Minimal and maximal distances between x and y
+//'
+//' Blocks of rows of x are compared in parallel against tiles of TILE_NY
+//' points of y, as for full distance matrices, with one minimum and maximum
+//' for each thread.
+//' @noRd
+static void KERNEL (xy_range) (const point_tables *p1, const point_tables *p2,
+        double cosy, int simd, int nthreads, double *range)
+{
+    size_t nx = p1->n, ny = p2->n;
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (nx, nthreads, &nblocks);
+    double *ranges = kernel_ranges (nthreads);
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        double *r = ranges + THREAD_SLOT * omp_get_thread_num ();
+        double row [TILE_NY];
+#if KERNEL_TILED
+        for (size_t j0 = 0; j0 < ny; j0 += TILE_NY)
+        {
+            size_t nb = (j0 + TILE_NY < ny) ? TILE_NY : ny - j0;
+            for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+            {
+                if (point_na (p1, i))
+                    continue;
+                KERNEL (row_na) (p1, i, p2, j0, nb, cosy, simd, row);
+                kernel_minmax (row, nb, r);
+            }
+        }
+#else
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            if (point_na (p1, i))
+                continue;
+            for (size_t j0 = 0; j0 < ny; j0 += TILE_NY)
+            {
+                size_t nb = (j0 + TILE_NY < ny) ? TILE_NY : ny - j0;
+                KERNEL (row_na) (p1, i, p2, j0, nb, cosy, simd, row);
+                kernel_minmax (row, nb, r);
+            }
+        }
+#endif
+    }
+    end_check_interrupt (interrupted);
+
+    kernel_ranges_combine (ranges, nthreads, range);
+}
+
+//' Minimal and maximal distances between successive points of x
+//' @noRd
+static void KERNEL (seq_range) (const point_tables *p, double cosy, int simd,
+        double *range)
+{
+    point_tables p2;
+    point_tables_shift (p, 1, &p2);
+    double buf [TILE_NY];
+
+    range [0] = 100.0 * equator;
+    range [1] = -100.0 * equator;
+
+    for (size_t i0 = 0; i0 < p2.n; i0 += TILE_NY)
+    {
+        size_t nb = (i0 + TILE_NY < p2.n) ? TILE_NY : p2.n - i0;
+        KERNEL (pairs) (p, &p2, i0, nb, cosy, simd, buf);
+        na_mask_pairs (p, &p2, i0, nb, buf);
+        kernel_minmax (buf, nb, range);
+    }
+}
+
+#undef KERNEL
+#undef KERNEL_CAT
+#undef KERNEL_CAT2
+#undef KERNEL_MEASURE
+#undef KERNEL_TILED
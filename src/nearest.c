@@ -0,0 +1,484 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "nearest.h"
+#include "kernels.h"
+
+// Distances in the projected space are inflated by these tolerances before
+// searching, so candidates are never lost to rounding differences between the
+// projection and the actual distance calculations.
+#define NN_REL_TOL 1.0e-9
+#define NN_ABS_TOL 1.0e-9
+
+//' Whether a kd-tree should be used for nearest-neighbour searches
+//' @noRd
+int nn_use_tree (size_t nx, size_t ny)
+{
+    return ny >= NN_MIN_NY && (double) nx * (double) ny >= NN_MIN_PAIRS;
+}
+
+//' Project a point into the Euclidean space of the tree
+//'
+//' Spherical measures use 3D unit vectors, so that chord lengths are monotonic
+//' in great circle distance, and dateline and polar wrapping come for free.
+//' Cheap distances are Euclidean in scaled lon-lat, and so are projected
+//' directly into the metric equivalents.
+//' @noRd
+void nn_project (const nn_tree *t, double x, double y, double *pos)
+{
+    if (t->measure == MEASURE_CHEAP)
+    {
+        pos [0] = equator * x * t->proj_cosy / 360.0;
+        pos [1] = meridian * y / 180.0;
+    } else
+    {
+        double lon = x * M_PI / 180.0, lat = y * M_PI / 180.0;
+        pos [0] = cos (lat) * cos (lon);
+        pos [1] = cos (lat) * sin (lon);
+        pos [2] = sin (lat);
+    }
+}
+
+//' Distance between two points with the measure of the tree
+//'
+//' Calculated in exactly the same way as the brute-force kernels, so that
+//' both give identical results. Each call is counted as one evaluated pair
+//' for instrumented calls.
+//' @noRd
+double nn_dist (const nn_tree *t, double x1, double y1, double x2, double y2)
+{
+    double d;
+    stats_count (1.0);
+    switch (t->measure)
+    {
+        case MEASURE_HAVERSINE:
+            d = one_haversine (x1, y1, x2, y2,
+                    cos (y1 * M_PI / 180.0), cos (y2 * M_PI / 180.0));
+            break;
+        case MEASURE_VINCENTY:
+            d = one_vincenty (x1, x2,
+                    sin (y1 * M_PI / 180.0), cos (y1 * M_PI / 180.0),
+                    sin (y2 * M_PI / 180.0), cos (y2 * M_PI / 180.0));
+            break;
+        case MEASURE_CHEAP:
+            d = one_cheap (x1, y1, x2, y2, t->cosy);
+            break;
+        default:
+            d = one_geodesic (x1, y1, x2, y2);
+    }
+    return d;
+}
+
+//' Radius in the projected space containing all points within distance d
+//'
+//' Cheap projections of prepared points use the multiplier of those points
+//' alone, which may exceed that of the distances, in which case the radius
+//' is inflated by the ratio of the two.
+//' @noRd
+double nn_search_radius (const nn_tree *t, double d)
+{
+    double r;
+
+    if (t->measure == MEASURE_CHEAP)
+    {
+        r = d;
+        if (t->proj_cosy > t->cosy)
+            r = (t->cosy > 0.0) ? d * t->proj_cosy / t->cosy : R_PosInf;
+    } else
+    {
+        double theta = d / earth;
+        if (t->measure == MEASURE_GEODESIC)
+            theta /= geodesic_sphere_ratio;
+        r = (theta >= M_PI) ? 2.0 : 2.0 * sin (theta / 2.0);
+    }
+
+    return r * (1.0 + NN_REL_TOL) + NN_ABS_TOL;
+}
+
+static void nn_tree_finalizer (SEXP tree_)
+{
+    nn_tree *t = (nn_tree *) R_ExternalPtrAddr (tree_);
+    if (t)
+    {
+        if (t->tree)
+            kd_free (t->tree);
+        free (t->index);
+        free (t);
+        R_ClearExternalPtr (tree_);
+    }
+}
+
+//' Build a kd-tree over a set of points
+//'
+//' Points with non-finite coordinates are skipped. Points are inserted in a
+//' fixed pseudo-random order, because kdtree does no rebalancing, and
+//' inserting points which are already sorted (such as GPS traces) would
+//' otherwise produce a degenerate tree.
+//'
+//' @param lon, lat Coordinates of points, which must remain valid for the
+//' lifetime of the tree.
+//' @param cosy Constant cosine multiplier of cheap distances; ignored for
+//' other measures.
+//' @return External pointer to an `nn_tree`, freed on garbage collection, so
+//' that trees are not leaked when a calculation is interrupted.
+//' @noRd
+SEXP nn_tree_create (const double *lon, const double *lat, size_t n,
+        measure_t measure, double cosy)
+{
+    nn_tree *t = (nn_tree *) calloc (1, sizeof (nn_tree));
+    if (!t)
+        Rf_error ("Unable to allocate kd-tree"); // # nocov
+
+    SEXP tree_ = PROTECT (R_MakeExternalPtr (t, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx (tree_, nn_tree_finalizer, TRUE);
+
+    t->lon = lon;
+    t->lat = lat;
+    t->n = n;
+    t->measure = measure;
+    t->cosy = cosy;
+    t->proj_cosy = cosy;
+    t->tree = kd_create (measure == MEASURE_CHEAP ? 2 : 3);
+    t->index = (size_t *) malloc (n * sizeof (size_t));
+    if (!t->tree || !t->index)
+        Rf_error ("Unable to allocate kd-tree"); // # nocov
+
+    for (size_t i = 0; i < n; i++)
+        t->index [i] = i;
+
+    // Fisher-Yates shuffle with a fixed xorshift generator, so that R's RNG
+    // state is left untouched, and results are reproducible.
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = (n > 0) ? n - 1 : 0; i > 0; i--)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t j = (size_t) (state % (uint64_t) (i + 1));
+        size_t tmp = t->index [i];
+        t->index [i] = t->index [j];
+        t->index [j] = tmp;
+    }
+
+    // Non-finite coordinates are not inserted, and so are never neighbours.
+    double pos [3];
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t j = t->index [i];
+        if (!isfinite (lon [j]) || !isfinite (lat [j]))
+            continue;
+        nn_project (t, lon [j], lat [j], pos);
+        if (kd_insert (t->tree, pos, t->index + i) != 0)
+            Rf_error ("Unable to allocate kd-tree"); // # nocov
+        t->ntree++;
+    }
+
+    UNPROTECT (1);
+
+    return tree_;
+}
+
+nn_tree * nn_tree_get (SEXP tree_)
+{
+    return (nn_tree *) R_ExternalPtrAddr (tree_);
+}
+
+//' Index of nearest point in tree to (x, y)
+//'
+//' The nearest point in projected space gives an upper bound on the distance
+//' to the actual nearest point, and all points within the corresponding
+//' search radius are then compared with the actual distance measure. Ties are
+//' resolved in favour of the lowest index, as in the brute-force kernels.
+//'
+//' @param dmin Distance to the nearest point.
+//' @return Index of the nearest point, or NN_FAILED if the search failed.
+//' @noRd
+size_t nn_nearest (const nn_tree *t, double x, double y, double *dmin)
+{
+    double pos [3];
+    size_t jmin;
+    struct kdres *res;
+
+    if (t->ntree == 0)
+    {
+        *dmin = NA_REAL;
+        return 0;
+    }
+
+    nn_project (t, x, y, pos);
+
+    res = kd_nearest (t->tree, pos);
+    if (!res)
+        return NN_FAILED; // # nocov
+    jmin = *((size_t *) kd_res_item_data (res));
+    kd_res_free (res);
+    *dmin = nn_dist (t, x, y, t->lon [jmin], t->lat [jmin]);
+
+    res = kd_nearest_range (t->tree, pos, nn_search_radius (t, *dmin));
+    if (!res)
+        return NN_FAILED; // # nocov
+    while (!kd_res_end (res))
+    {
+        size_t j = *((size_t *) kd_res_item_data (res));
+        double d = nn_dist (t, x, y, t->lon [j], t->lat [j]);
+        if (d < *dmin || (d == *dmin && j < jmin))
+        {
+            *dmin = d;
+            jmin = j;
+        }
+        kd_res_next (res);
+    }
+    kd_res_free (res);
+
+    return jmin;
+}
+
+//' The nearest neighbour in tree of (x, y) by squared chord lengths
+//'
+//' For haversine trees with 'options (geodist.chord = TRUE)'. Points of the
+//' tree are projected in exactly the same way as `unit_vectors()`, so that
+//' chord lengths between projections are identical to those compared by the
+//' brute-force kernels, and are compared directly, without any distances.
+//' @return Index of the nearest point, or NN_FAILED if the search failed.
+//' @noRd
+size_t nn_nearest_chord (const nn_tree *t, double x, double y)
+{
+    double pos [3], q [3];
+    size_t jmin;
+    struct kdres *res;
+
+    if (t->ntree == 0)
+        return 0;
+
+    nn_project (t, x, y, pos);
+
+    res = kd_nearest (t->tree, pos);
+    if (!res)
+        return NN_FAILED; // # nocov
+    jmin = *((size_t *) kd_res_item (res, q));
+    kd_res_free (res);
+    double c2min = chord2 (pos, q);
+
+    res = kd_nearest_range (t->tree, pos,
+            sqrt (c2min) * (1.0 + NN_REL_TOL) + NN_ABS_TOL);
+    if (!res)
+        return NN_FAILED; // # nocov
+    double neval = 1.0;
+    while (!kd_res_end (res))
+    {
+        size_t j = *((size_t *) kd_res_item (res, q));
+        double c2 = chord2 (pos, q);
+        if (c2 < c2min || (c2 == c2min && j < jmin))
+        {
+            c2min = c2;
+            jmin = j;
+        }
+        neval++;
+        kd_res_next (res);
+    }
+    kd_res_free (res);
+    stats_count (neval);
+
+    return jmin;
+}
+
+// Ordering of neighbours by distance, then by index, so that ties are
+// resolved in the same way as in nn_nearest.
+static int nn_match_gt (const nn_match *a, const nn_match *b)
+{
+    return a->d > b->d || (a->d == b->d && a->j > b->j);
+}
+
+static void heap_sift_down (nn_match *h, size_t n, size_t i)
+{
+    while (1)
+    {
+        size_t largest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < n && nn_match_gt (h + left, h + largest))
+            largest = left;
+        if (right < n && nn_match_gt (h + right, h + largest))
+            largest = right;
+        if (largest == i)
+            break;
+        nn_match tmp = h [i];
+        h [i] = h [largest];
+        h [largest] = tmp;
+        i = largest;
+    }
+}
+
+// Push onto a bounded max-heap of capacity k holding the k nearest matches.
+static void heap_push (nn_match *h, size_t *n, size_t k, nn_match m)
+{
+    if (*n < k)
+    {
+        size_t i = (*n)++;
+        h [i] = m;
+        while (i > 0)
+        {
+            size_t parent = (i - 1) / 2;
+            if (!nn_match_gt (h + i, h + parent))
+                break;
+            nn_match tmp = h [i];
+            h [i] = h [parent];
+            h [parent] = tmp;
+            i = parent;
+        }
+    } else if (nn_match_gt (h, &m))
+    {
+        h [0] = m;
+        heap_sift_down (h, k, 0);
+    }
+}
+
+//' The k nearest neighbours in tree of (x, y)
+//'
+//' The k nearest points in projected space give an upper bound on the
+//' distance to the k-th nearest neighbour, and all points within the
+//' corresponding search radius are then compared with the actual measure,
+//' keeping the k nearest in a bounded heap.
+//'
+//' @param res Array of length k filled with neighbours in order of increasing
+//' distance.
+//' @return Number of neighbours found, which is less than k only if the tree
+//' has fewer than k points, or if (x, y) is not finite, or NN_FAILED if the
+//' search failed.
+//' @noRd
+size_t nn_knn (const nn_tree *t, double x, double y, size_t k, nn_match *res)
+{
+    double pos [3], dmax = 0.0;
+    size_t n = 0;
+    struct kdres *kres;
+
+    if (t->ntree == 0 || k == 0 || !isfinite (x) || !isfinite (y))
+        return 0;
+
+    nn_project (t, x, y, pos);
+
+    kres = kd_nearest_n (t->tree, pos, (int) k);
+    if (!kres)
+        return NN_FAILED; // # nocov
+    while (!kd_res_end (kres))
+    {
+        size_t j = *((size_t *) kd_res_item_data (kres));
+        double d = nn_dist (t, x, y, t->lon [j], t->lat [j]);
+        if (d > dmax)
+            dmax = d;
+        kd_res_next (kres);
+    }
+    kd_res_free (kres);
+
+    kres = kd_nearest_range (t->tree, pos, nn_search_radius (t, dmax));
+    if (!kres)
+        return NN_FAILED; // # nocov
+    while (!kd_res_end (kres))
+    {
+        nn_match m;
+        m.j = *((size_t *) kd_res_item_data (kres));
+        m.d = nn_dist (t, x, y, t->lon [m.j], t->lat [m.j]);
+        heap_push (res, &n, k, m);
+        kd_res_next (kres);
+    }
+    kd_res_free (kres);
+
+    // heap sort into increasing order:
+    for (size_t i = n; i > 1; i--)
+    {
+        nn_match tmp = res [0];
+        res [0] = res [i - 1];
+        res [i - 1] = tmp;
+        heap_sift_down (res, i - 1, 0);
+    }
+
+    return n;
+}
+
+static int nn_match_cmp_index (const void *a, const void *b)
+{
+    size_t ja = ((const nn_match *) a)->j, jb = ((const nn_match *) b)->j;
+    return (ja > jb) - (ja < jb);
+}
+
+//' Append one match, growing the array as needed
+//' @return 0 if a heap array could not grow, in which case 'failed' is set,
+//' otherwise 1
+//' @noRd
+int nn_matches_add (nn_matches *res, nn_match m)
+{
+    if (res->n == res->capacity)
+    {
+        size_t capacity = (res->capacity < 1024) ? 1024 :
+            2 * res->capacity;
+        nn_match *m_new;
+        if (res->heap)
+        {
+            m_new = (nn_match *) realloc (res->m,
+                    capacity * sizeof (nn_match));
+            if (!m_new)
+            {
+                res->failed = 1; // # nocov
+                return 0; // # nocov
+            }
+        } else
+        {
+            m_new = (nn_match *) stats_alloc (capacity, sizeof (nn_match));
+            if (res->n > 0)
+                memcpy (m_new, res->m, res->n * sizeof (nn_match));
+        }
+        res->m = m_new;
+        res->capacity = capacity;
+    }
+    res->m [res->n++] = m;
+    return 1;
+}
+
+//' Sort the matches appended from position n0 by increasing index
+//' @noRd
+void nn_matches_sort (nn_matches *res, size_t n0)
+{
+    qsort (res->m + n0, res->n - n0, sizeof (nn_match), nn_match_cmp_index);
+}
+
+//' All neighbours in tree within 'radius' of (x, y)
+//'
+//' @param res Matches are appended to this array, in order of increasing
+//' index. 'failed' is set if the search failed, so that errors are never
+//' raised from worker threads.
+//' @return Number of neighbours found
+//' @noRd
+size_t nn_within (const nn_tree *t, double x, double y, double radius,
+        nn_matches *res)
+{
+    double pos [3];
+    size_t n0 = res->n;
+    struct kdres *kres;
+
+    if (t->ntree == 0 || !isfinite (x) || !isfinite (y))
+        return 0;
+
+    nn_project (t, x, y, pos);
+
+    kres = kd_nearest_range (t->tree, pos, nn_search_radius (t, radius));
+    if (!kres)
+    {
+        res->failed = 1; // # nocov
+        return 0; // # nocov
+    }
+    while (!kd_res_end (kres))
+    {
+        nn_match m;
+        m.j = *((size_t *) kd_res_item_data (kres));
+        m.d = nn_dist (t, x, y, t->lon [m.j], t->lat [m.j]);
+        kd_res_next (kres);
+        if (m.d > radius)
+            continue;
+
+        if (!nn_matches_add (res, m))
+            break; // # nocov
+    }
+    kd_res_free (kres);
+
+    nn_matches_sort (res, n0);
+
+    return res->n - n0;
+}
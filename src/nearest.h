@@ -0,0 +1,80 @@
+#ifndef NEAREST_H
+#define NEAREST_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stdint.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "kdtree.h"
+
+// kd-trees are only used for nearest-neighbour searches when both of these are
+// exceeded; below them, the brute-force scan is faster than building a tree.
+#define NN_MIN_NY 64
+#define NN_MIN_PAIRS 100000
+
+// Index returned by failed searches of a tree. Searches may be made from
+// worker threads, and so never raise errors themselves.
+#define NN_FAILED SIZE_MAX
+
+// Lower bound on the ratio of WGS-84 geodesic distances to great circle
+// distances on a sphere of radius 'earth' between the same geodetic lon-lat
+// coordinates. The actual minimum is (1 - e^2) = 0.993306 for short
+// meridional distances at the equator; (1 - 3f) = 0.98994 leaves a margin.
+static const double geodesic_sphere_ratio = 1.0 - 3.0 * flattening;
+
+// Spatial index of one set of points, searched in a Euclidean projection (3D
+// unit vectors, or 2D cheap-ruler metric coordinates) in which the distance
+// between any two points gives a lower bound on the actual distance measure.
+typedef struct
+{
+    struct kdtree *tree;
+    size_t *index; // data pointers of tree nodes
+    const double *lon, *lat; // coordinates of indexed points (not owned)
+    size_t n;
+    size_t ntree; // number of points in tree, excluding non-finite values
+    measure_t measure;
+    double cosy; // constant cosine multiplier for cheap distances
+    double proj_cosy; // multiplier of cheap projections, which may differ
+} nn_tree;
+
+int nn_use_tree (size_t nx, size_t ny);
+
+SEXP nn_tree_create (const double *lon, const double *lat, size_t n,
+        measure_t measure, double cosy);
+nn_tree * nn_tree_get (SEXP tree_);
+
+double nn_dist (const nn_tree *t, double x1, double y1, double x2, double y2);
+double nn_search_radius (const nn_tree *t, double d);
+void nn_project (const nn_tree *t, double x, double y, double *pos);
+
+// Index and distance of one neighbour of a query point
+typedef struct
+{
+    size_t j;
+    double d;
+} nn_match;
+
+// Growable array of neighbours of query points, allocated with R_alloc, or
+// with realloc if 'heap' is set, so that arrays may grow within parallel
+// regions. Heap arrays must be freed by the caller, and set 'failed' instead
+// of raising errors if they can not grow, or if a search of a tree fails.
+typedef struct
+{
+    nn_match *m;
+    size_t n, capacity;
+    int heap, failed;
+} nn_matches;
+
+int nn_matches_add (nn_matches *res, nn_match m);
+void nn_matches_sort (nn_matches *res, size_t n0);
+
+size_t nn_nearest (const nn_tree *t, double x, double y, double *dmin);
+size_t nn_nearest_chord (const nn_tree *t, double x, double y);
+size_t nn_knn (const nn_tree *t, double x, double y, size_t k, nn_match *res);
+size_t nn_within (const nn_tree *t, double x, double y, double radius,
+        nn_matches *res);
+
+#endif /* NEAREST_H */
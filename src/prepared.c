@@ -0,0 +1,343 @@
+#include <string.h>
+
+#include "prepared.h"
+
+static void prepared_finalizer (SEXP prep_)
+{
+    prepared_pts *p = (prepared_pts *) R_ExternalPtrAddr (prep_);
+    if (p)
+    {
+        free (p->x);
+        free (p->y);
+        free (p->siny);
+        free (p->cosy);
+        free (p->pts);
+        free (p->u);
+        free (p->na);
+        free (p);
+        R_ClearExternalPtr (prep_);
+    }
+}
+
+static void * prepared_alloc (size_t n, size_t size)
+{
+    void *r = malloc ((n > 0 ? n : 1) * size);
+    if (!r)
+        Rf_error ("Unable to allocate prepared points"); // # nocov
+    return r;
+}
+
+//' Prepare one set of points for repeated queries
+//'
+//' Coordinates and per-point terms are calculated in exactly the same way as
+//' in `point_tables_init()`, so that all queries give results identical to
+//' those of the unprepared kernels. The kd-tree over the points is held in the
+//' protected field of the external pointer. Cheap projections of the tree use
+//' the latitudes of these points alone, with actual distances using the
+//' multiplier of each query; see `nn_search_radius()`.
+//'
+//' @return External pointer to a `prepared_pts`, freed on garbage collection.
+//' @noRd
+static SEXP prepare (measure_t measure, SEXP y_)
+{
+    size_t n = (size_t) (floor (length (y_) / 2));
+
+    y_ = PROTECT (Rf_coerceVector (y_, REALSXP));
+    const double *ry = REAL (y_);
+    const unsigned char *na = coords_validate (ry, ry + n, n);
+
+    prepared_pts *p = (prepared_pts *) calloc (1, sizeof (prepared_pts));
+    if (!p)
+        Rf_error ("Unable to allocate prepared points"); // # nocov
+
+    SEXP prep_ = PROTECT (R_MakeExternalPtr (p,
+                Rf_install ("geodist_prepared"), R_NilValue));
+    R_RegisterCFinalizerEx (prep_, prepared_finalizer, TRUE);
+
+    p->measure = measure;
+    p->n = n;
+    p->x = (double *) prepared_alloc (n, sizeof (double));
+    p->y = (double *) prepared_alloc (n, sizeof (double));
+    memcpy (p->x, ry, n * sizeof (double));
+    memcpy (p->y, ry + n, n * sizeof (double));
+
+    if (measure == MEASURE_HAVERSINE || measure == MEASURE_VINCENTY)
+    {
+        p->cosy = (double *) prepared_alloc (n, sizeof (double));
+        for (size_t i = 0; i < n; i++)
+            p->cosy [i] = cos (p->y [i] * M_PI / 180.0);
+    }
+    if (measure == MEASURE_HAVERSINE)
+    {
+        // Unit vectors are always prepared, but only used with queries of
+        // 'options (geodist.chord = TRUE)':
+        p->u = (double *) prepared_alloc (3 * n, sizeof (double));
+        memcpy (p->u, unit_vectors (p->x, p->y, n), 3 * n * sizeof (double));
+    }
+    if (measure == MEASURE_VINCENTY)
+    {
+        p->siny = (double *) prepared_alloc (n, sizeof (double));
+        for (size_t i = 0; i < n; i++)
+            p->siny [i] = sin (p->y [i] * M_PI / 180.0);
+    }
+    if (measure == MEASURE_GEODESIC)
+    {
+        const struct geod_geodesic *g = geodesic_wgs84 ();
+        p->pts = (struct geod_point *) prepared_alloc (n,
+                sizeof (struct geod_point));
+        for (size_t i = 0; i < n; i++)
+            geod_pointinit (g, p->pts + i, p->y [i], p->x [i]);
+    }
+
+    // Range of latitudes with the same comparisons as `cheap_cosy()`, which
+    // ignore NaN and infinite values:
+    double ymin = 9999.9, ymax = -9999.9;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (isinf (p->y [i]))
+            continue;
+        if (p->y [i] < ymin)
+            ymin = p->y [i];
+        if (p->y [i] > ymax)
+            ymax = p->y [i];
+    }
+    p->yrange [0] = ymin;
+    p->yrange [1] = ymax;
+    p->nyrange = (ymin <= ymax) ? 2 : 0;
+    p->finite = (na == NULL);
+    if (na)
+    {
+        p->na = (unsigned char *) prepared_alloc (n, 1);
+        memcpy (p->na, na, n);
+    }
+
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (p->y, n, NULL, 0);
+    SEXP tree_ = PROTECT (nn_tree_create (p->x, p->y, n, measure, cosy));
+    R_SetExternalPtrProtected (prep_, tree_);
+
+    UNPROTECT (3);
+
+    return prep_;
+}
+
+static prepared_pts * prepared_get (SEXP prep_)
+{
+    if (TYPEOF (prep_) != EXTPTRSXP ||
+            R_ExternalPtrTag (prep_) != Rf_install ("geodist_prepared"))
+        Rf_error ("y must be a 'geodist_prepared' object");
+    prepared_pts *p = (prepared_pts *) R_ExternalPtrAddr (prep_);
+    if (!p)
+        Rf_error ("prepared points are no longer valid, and must be re-created");
+    return p;
+}
+
+static void prepared_tables (const prepared_pts *p, point_tables *pt)
+{
+    pt->x = p->x;
+    pt->y = p->y;
+    pt->siny = p->siny;
+    pt->cosy = p->cosy;
+    pt->pts = p->pts;
+    pt->n = p->n;
+    pt->u = p->u;
+    pt->na = p->na;
+}
+
+//' Constant cosine multiplier for cheap distances between query latitudes
+//' and prepared points, identical to `cheap_cosy()` of both sets together
+//' @noRd
+static double prepared_cosy (const prepared_pts *p, const double *y,
+        size_t n)
+{
+    if (p->measure != MEASURE_CHEAP)
+        return 0.0;
+    return cheap_cosy (y, n, p->yrange, p->nyrange);
+}
+
+//' Copy of the kd-tree of prepared points, with the multiplier of cheap
+//' distances of one query
+//' @noRd
+static nn_tree prepared_tree (SEXP prep_, double cosy)
+{
+    nn_tree t = *nn_tree_get (R_ExternalPtrProtected (prep_));
+    t.cosy = cosy;
+    return t;
+}
+
+//' R_haversine_prepare
+//' @param y_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_haversine_prepare (SEXP y_)
+{
+    return prepare (MEASURE_HAVERSINE, y_);
+}
+
+//' R_vincenty_prepare
+//' @param y_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_vincenty_prepare (SEXP y_)
+{
+    return prepare (MEASURE_VINCENTY, y_);
+}
+
+//' R_cheap_prepare
+//' @param y_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_cheap_prepare (SEXP y_)
+{
+    return prepare (MEASURE_CHEAP, y_);
+}
+
+//' R_geodesic_prepare
+//' @param y_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @noRd
+SEXP R_geodesic_prepare (SEXP y_)
+{
+    return prepare (MEASURE_GEODESIC, y_);
+}
+
+//' R_prepared_xy
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param prep_ Prepared points from one of the `R_<measure>_prepare`
+//' functions
+//' @return As for `R_haversine_xy`
+//' @noRd
+SEXP R_prepared_xy (SEXP x_, SEXP prep_, SEXP threads_)
+{
+    prepared_pts *p = prepared_get (prep_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    SEXP out = PROTECT (allocVector (REALSXP, nx * p->n));
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_);
+
+    point_tables p1, p2;
+    point_tables_init (p->measure, rx, rx + nx, nx, &p1);
+    prepared_tables (p, &p2);
+
+    kernel_xy_dists (p->measure, &p1, &p2, prepared_cosy (p, rx + nx, nx),
+            nthreads, REAL (out));
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_prepared_xy_min
+//' @param x_, prep_ As for `R_prepared_xy`
+//' @return As for `R_haversine_xy_min`
+//' @noRd
+SEXP R_prepared_xy_min (SEXP x_, SEXP prep_, SEXP threads_)
+{
+    prepared_pts *p = prepared_get (prep_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    SEXP out = PROTECT (allocVector (INTSXP, nx));
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_);
+    double cosy = prepared_cosy (p, rx + nx, nx);
+    const unsigned char *na = coords_validate (rx, rx + nx, nx);
+
+    if (nn_use_tree (nx, p->n) && p->finite && na == NULL)
+    {
+        nn_tree t = prepared_tree (prep_, cosy);
+        xy_min_tree_search (&t, rx, rx + nx, nx, nthreads, INTEGER (out));
+    } else
+    {
+        point_tables p1, p2;
+        point_tables_init_na (p->measure, rx, rx + nx, nx, na, &p1);
+        prepared_tables (p, &p2);
+        xy_min_tables (p->measure, &p1, &p2, cosy, nthreads, INTEGER (out));
+    }
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_prepared_xy_range
+//' @param x_, prep_, threads_ As for `R_prepared_xy`
+//' @return As for `R_haversine_xy_range`
+//' @noRd
+SEXP R_prepared_xy_range (SEXP x_, SEXP prep_, SEXP threads_)
+{
+    prepared_pts *p = prepared_get (prep_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    SEXP out = PROTECT (allocVector (REALSXP, 2));
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_);
+
+    point_tables p1, p2;
+    point_tables_init (p->measure, rx, rx + nx, nx, &p1);
+    prepared_tables (p, &p2);
+
+    kernel_xy_range (p->measure, &p1, &p2, prepared_cosy (p, rx + nx, nx),
+            nthreads, REAL (out));
+
+    UNPROTECT (2);
+
+    return out;
+}
+
+//' R_prepared_knn
+//' @param x_, prep_ As for `R_prepared_xy`
+//' @param k_ Number of nearest neighbours
+//' @return As for `R_haversine_knn`
+//' @noRd
+SEXP R_prepared_knn (SEXP x_, SEXP prep_, SEXP k_)
+{
+    prepared_pts *p = prepared_get (prep_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    size_t k = (size_t) Rf_asInteger (k_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_);
+    coords_validate (rx, rx + nx, nx);
+
+    nn_tree t = prepared_tree (prep_, prepared_cosy (p, rx + nx, nx));
+    SEXP out = knn_tree_search (&t, rx, rx + nx, nx, k);
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+//' R_prepared_within
+//' @param x_, prep_ As for `R_prepared_xy`
+//' @param r_ Maximal distance in metres
+//' @return As for `R_haversine_within`
+//' @noRd
+SEXP R_prepared_within (SEXP x_, SEXP prep_, SEXP r_)
+{
+    prepared_pts *p = prepared_get (prep_);
+    size_t nx = (size_t) (floor (length (x_) / 2));
+    double radius = Rf_asReal (r_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_);
+    coords_validate (rx, rx + nx, nx);
+
+    nn_tree t = prepared_tree (prep_, prepared_cosy (p, rx + nx, nx));
+    SEXP out = within_tree_search (&t, rx, rx + nx, nx, radius, 0, 1);
+
+    UNPROTECT (1);
+
+    return out;
+}
+
+//' Number of pairs between x and prepared points, for instrumented calls
+//' @noRd
+double stats_pairs_prepared (SEXP x_, SEXP prep_)
+{
+    prepared_pts *p = (TYPEOF (prep_) == EXTPTRSXP) ?
+        (prepared_pts *) R_ExternalPtrAddr (prep_) : NULL;
+    if (!p)
+        return 0.0;
+    return floor ((double) Rf_xlength (x_) / 2.0) * (double) p->n;
+}
@@ -0,0 +1,46 @@
+#ifndef PREPARED_H
+#define PREPARED_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "threads.h"
+#include "dists_xy.h"
+#include "dists_xy_min.h"
+#include "dists_knn.h"
+#include "range_xy.h"
+
+// One set of points prepared for repeated queries against other points, with
+// coordinates, per-point terms of the measure, and a kd-tree, all held outside
+// of R and calculated only once.
+typedef struct
+{
+    measure_t measure;
+    size_t n;
+    double *x, *y; // longitudes and latitudes
+    double *siny, *cosy; // NULL unless needed by the measure
+    struct geod_point *pts; // geodesic only
+    double *u; // unit vectors, haversine only
+    unsigned char *na; // missing points, or NULL if all are finite
+    double yrange [2]; // range of latitudes, for cheap multipliers
+    size_t nyrange; // 2, or 0 if all latitudes are missing
+    int finite; // 1 if all coordinates are finite
+} prepared_pts;
+
+SEXP R_haversine_prepare (SEXP y_);
+SEXP R_vincenty_prepare (SEXP y_);
+SEXP R_cheap_prepare (SEXP y_);
+SEXP R_geodesic_prepare (SEXP y_);
+
+SEXP R_prepared_xy (SEXP x_, SEXP prep_, SEXP threads_);
+SEXP R_prepared_xy_min (SEXP x_, SEXP prep_, SEXP threads_);
+SEXP R_prepared_xy_range (SEXP x_, SEXP prep_, SEXP threads_);
+SEXP R_prepared_knn (SEXP x_, SEXP prep_, SEXP k_);
+SEXP R_prepared_within (SEXP x_, SEXP prep_, SEXP r_);
+
+double stats_pairs_prepared (SEXP x_, SEXP prep_);
+
+#endif /* PREPARED_H */
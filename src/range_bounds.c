@@ -0,0 +1,472 @@
+#include "range_bounds.h"
+
+// Exact ranges of distances between all pairs of one set of points, without
+// evaluating all pairs. The minimum is the smallest distance from any point to
+// its nearest neighbour in a kd-tree. The maximum is bounded from below by the
+// distances between vertices of the convex hull of all points, and from above
+// for each point by its distance to the farthest of those vertices. Only those
+// points which may then be an end of the farthest pair are compared exactly.
+
+// Bounds are calculated in projected coordinates, which may differ from the
+// actual distances by rounding, and so are inflated by these tolerances. They
+// only ever admit more candidate points.
+#define BOUNDS_REL_TOL 1.0e-8
+#define BOUNDS_ABS_TOL 1.0e-3
+
+// Minimal cosine of the angle between each point and the mean direction of all
+// points for spherical bounds. Points within this cap of 45 degrees are all
+// less than 90 degrees apart, so that distances from any point are convex
+// over the spherical hull of all others, and are maximal at one of its
+// vertices.
+#define BOUNDS_MIN_COS 0.7072
+
+// Upper bound on the ratio of WGS-84 geodesic distances to great circle
+// distances on a sphere of radius 'earth' between the same geodetic lon-lat
+// coordinates. The ellipsoid is nowhere stretched by more than a / b =
+// 1 / (1 - f) relative to that sphere; (1 + 3f) leaves a margin, as for the
+// lower bound of nearest.c.
+static const double geodesic_sphere_max = 1.0 + 3.0 * flattening;
+
+typedef struct
+{
+    double x, y;
+    size_t k;
+} bounds_pt;
+
+static int bounds_pt_cmp (const void *a, const void *b)
+{
+    const bounds_pt *pa = (const bounds_pt *) a, *pb = (const bounds_pt *) b;
+    if (pa->x != pb->x)
+        return (pa->x < pb->x) ? -1 : 1;
+    if (pa->y != pb->y)
+        return (pa->y < pb->y) ? -1 : 1;
+    return 0;
+}
+
+static double bounds_cross (const bounds_pt *o, const bounds_pt *a,
+        const bounds_pt *b)
+{
+    return (a->x - o->x) * (b->y - o->y) - (a->y - o->y) * (b->x - o->x);
+}
+
+//' Vertices of the convex hull of n points in the plane
+//'
+//' Andrew's monotone chain, in O(n log n). Collinear points on edges are not
+//' vertices.
+//'
+//' @param pts Points, which are sorted in place.
+//' @return R_alloc-ed array of hull vertices, of which there are nh.
+//' @noRd
+static bounds_pt * bounds_hull (bounds_pt *pts, size_t n, size_t *nh)
+{
+    qsort (pts, n, sizeof (bounds_pt), bounds_pt_cmp);
+
+    bounds_pt *h = (bounds_pt *) stats_alloc (2 * n + 1, sizeof (bounds_pt));
+    size_t k = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        while (k >= 2 && bounds_cross (h + k - 2, h + k - 1, pts + i) <= 0.0)
+            k--;
+        h [k++] = pts [i];
+    }
+    for (size_t i = n - 1, k0 = k + 1; i-- > 0; )
+    {
+        while (k >= k0 && bounds_cross (h + k - 2, h + k - 1, pts + i) <= 0.0)
+            k--;
+        h [k++] = pts [i];
+    }
+
+    // The last point repeats the first:
+    *nh = (k > 1) ? k - 1 : k;
+    return h;
+}
+
+//' Project the finite points of a tree into a plane in which their convex
+//' hull gives the farthest points from each point
+//'
+//' Cheap distances are already Euclidean in the plane of the tree. Points on
+//' the sphere are projected gnomonically about the mean direction of all
+//' points, which maps great circles onto straight lines, so that the planar
+//' hull is also the spherical hull.
+//'
+//' @param pos Coordinates of all finite points in the space of the tree.
+//' @return 0 if points are too widely spread for spherical bounds, otherwise
+//' 1.
+//' @noRd
+static int bounds_plane (const nn_tree *t, const double *pos, size_t nf,
+        bounds_pt *pts)
+{
+    if (t->measure == MEASURE_CHEAP)
+    {
+        for (size_t k = 0; k < nf; k++)
+        {
+            pts [k].x = pos [2 * k];
+            pts [k].y = pos [2 * k + 1];
+            pts [k].k = k;
+        }
+        return 1;
+    }
+
+    double c [3] = { 0.0, 0.0, 0.0 };
+    for (size_t k = 0; k < nf; k++)
+        for (int d = 0; d < 3; d++)
+            c [d] += pos [3 * k + d];
+    double len = sqrt (c [0] * c [0] + c [1] * c [1] + c [2] * c [2]);
+    if (!(len > 0.0))
+        return 0;
+    for (int d = 0; d < 3; d++)
+        c [d] /= len;
+
+    // Orthonormal basis of the plane tangent to c:
+    double e1 [3], e2 [3];
+    if (fabs (c [2]) < 0.9)
+    {
+        e1 [0] = -c [1];
+        e1 [1] = c [0];
+        e1 [2] = 0.0;
+    } else
+    {
+        e1 [0] = 0.0;
+        e1 [1] = -c [2];
+        e1 [2] = c [1];
+    }
+    len = sqrt (e1 [0] * e1 [0] + e1 [1] * e1 [1] + e1 [2] * e1 [2]);
+    for (int d = 0; d < 3; d++)
+        e1 [d] /= len;
+    e2 [0] = c [1] * e1 [2] - c [2] * e1 [1];
+    e2 [1] = c [2] * e1 [0] - c [0] * e1 [2];
+    e2 [2] = c [0] * e1 [1] - c [1] * e1 [0];
+
+    for (size_t k = 0; k < nf; k++)
+    {
+        const double *p = pos + 3 * k;
+        double pc = p [0] * c [0] + p [1] * c [1] + p [2] * c [2];
+        if (pc < BOUNDS_MIN_COS)
+            return 0;
+        pts [k].x = (p [0] * e1 [0] + p [1] * e1 [1] + p [2] * e1 [2]) / pc;
+        pts [k].y = (p [0] * e2 [0] + p [1] * e2 [1] + p [2] * e2 [2]) / pc;
+        pts [k].k = k;
+    }
+
+    return 1;
+}
+
+//' Distance in the space of the tree between finite points k and l, in
+//' metres, scaled to an upper bound on the actual distance measure
+//' @noRd
+static double bounds_upper (const nn_tree *t, const double *pos, size_t k,
+        size_t l)
+{
+    double d;
+    if (t->measure == MEASURE_CHEAP)
+    {
+        double dx = pos [2 * k] - pos [2 * l];
+        double dy = pos [2 * k + 1] - pos [2 * l + 1];
+        d = sqrt (dx * dx + dy * dy);
+    } else
+    {
+        double s = 0.0;
+        for (int i = 0; i < 3; i++)
+        {
+            double di = pos [3 * k + i] - pos [3 * l + i];
+            s += di * di;
+        }
+        s = sqrt (s) / 2.0;
+        d = 2.0 * earth * asin ((s < 1.0) ? s : 1.0);
+        if (t->measure == MEASURE_GEODESIC)
+            d *= geodesic_sphere_max;
+    }
+    return d * (1.0 + BOUNDS_REL_TOL) + BOUNDS_ABS_TOL;
+}
+
+//' Distance between points i and j, calculated with the same tables, row
+//' kernels, and order as in the upper triangle of `kernel_tri_range()`,
+//' because measures need not be exactly symmetric in floating point, and
+//' batch kernels differ from scalar kernels by rounding
+//'
+//' @param simd Whether batch kernels are used, from `batch_enabled()`
+//' @noRd
+static double bounds_dist (const nn_tree *t, const point_tables *p, int simd,
+        size_t i, size_t j)
+{
+    if (j < i)
+    {
+        size_t tmp = i;
+        i = j;
+        j = tmp;
+    }
+    stats_count (1.0);
+    double d;
+    kernel_row (t->measure, p, i, p, j, 1, t->cosy, simd, &d);
+    return d;
+}
+
+//' Distance from point i to the nearest other point by the distances of
+//' `bounds_dist()`, for haversine tables with unit vectors, or batch kernels
+//'
+//' Neighbours of the tree are ranked by scalar distances, which may differ
+//' from those of chord lengths or batch kernels by rounding, and so all
+//' points within the search radius of the distance d to the nearest neighbour
+//' of the tree are compared.
+//'
+//' @param d Distance to the nearest neighbour of the tree, replaced with the
+//' distance to the nearest point by `bounds_dist()`.
+//' @return 0 if the search failed, otherwise 1. Called from worker threads,
+//' and so never raises errors.
+//' @noRd
+static int bounds_nearest_rounded (const nn_tree *t, const point_tables *p,
+        int simd, size_t i, double *d)
+{
+    double pos [3];
+    nn_project (t, t->lon [i], t->lat [i], pos);
+
+    struct kdres *res = kd_nearest_range (t->tree, pos,
+            nn_search_radius (t, *d));
+    if (!res)
+        return 0; // # nocov
+    while (!kd_res_end (res))
+    {
+        size_t j = *((size_t *) kd_res_item_data (res));
+        if (j != i)
+        {
+            double dj = bounds_dist (t, p, simd, i, j);
+            if (dj < *d)
+                *d = dj;
+        }
+        kd_res_next (res);
+    }
+    kd_res_free (res);
+
+    return 1;
+}
+
+//' Maximal distance between all pairs of a subset of points of a tree
+//'
+//' @param idx Indices of the n points of the subset into the coordinates of
+//' the tree.
+//' @noRd
+static double bounds_max (const nn_tree *t, const point_tables *p, int simd,
+        const size_t *idx, size_t n, int nthreads)
+{
+    size_t nblocks;
+    size_t *blocks = tri_row_blocks (n, nthreads, &nblocks);
+    double *dmax = thread_slots (nthreads);
+    for (int i = 0; i < nthreads; i++)
+        dmax [THREAD_SLOT * i] = -100.0 * equator;
+    volatile int interrupted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        double *m = dmax + THREAD_SLOT * omp_get_thread_num ();
+        for (size_t i = blocks [b]; i < blocks [b + 1]; i++)
+        {
+            for (size_t j = i + 1; j < n; j++)
+            {
+                double d = bounds_dist (t, p, simd, idx [i], idx [j]);
+                if (d > *m)
+                    *m = d;
+            }
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    double res = -100.0 * equator;
+    for (int i = 0; i < nthreads; i++)
+        if (dmax [THREAD_SLOT * i] > res)
+            res = dmax [THREAD_SLOT * i];
+    return res;
+}
+
+static SEXP x_range_bounds (measure_t measure, SEXP x_, SEXP threads_)
+{
+    size_t n = (size_t) (floor (length (x_) / 2));
+    int nthreads = get_num_threads (threads_);
+
+    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
+    double *rx = REAL (x_), *ry = rx + n;
+
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (ry, n, NULL, 0);
+
+    SEXP out = PROTECT (allocVector (REALSXP, 2));
+    double *range = REAL (out);
+    range [0] = 100.0 * equator;
+    range [1] = -100.0 * equator;
+
+    point_tables p;
+    point_tables_init (measure, rx, ry, n, &p);
+
+    // Small inputs are faster to scan in full:
+    if (!nn_use_tree (n, n))
+    {
+        kernel_tri_range (measure, &p, cosy, nthreads, range);
+        UNPROTECT (2);
+        return out;
+    }
+
+    SEXP tree_ = PROTECT (nn_tree_create (rx, ry, n, measure, cosy));
+    const nn_tree *t = nn_tree_get (tree_);
+
+    size_t nf = 0;
+    size_t *idx = (size_t *) stats_alloc (n, sizeof (size_t));
+    for (size_t i = 0; i < n; i++)
+        if (isfinite (rx [i]) && isfinite (ry [i]))
+            idx [nf++] = i;
+
+    int dim = (measure == MEASURE_CHEAP) ? 2 : 3;
+    double *pos = (double *) stats_alloc (dim * nf, sizeof (double));
+    for (size_t k = 0; k < nf; k++)
+        nn_project (t, rx [idx [k]], ry [idx [k]], pos + dim * k);
+
+    bounds_pt *pts = (bounds_pt *) stats_alloc (nf, sizeof (bounds_pt));
+    if (nf < 2 || !bounds_plane (t, pos, nf, pts))
+    {
+        // Points spread over more than a hemisphere are scanned in full:
+        kernel_tri_range (measure, &p, cosy, nthreads, range);
+        UNPROTECT (3);
+        return out;
+    }
+
+    stats_counting ();
+    int simd = batch_enabled ();
+
+    size_t nblocks;
+    size_t *blocks = row_blocks (nf, nthreads, &nblocks);
+    double *dmin = thread_slots (nthreads);
+    for (int i = 0; i < nthreads; i++)
+        dmin [THREAD_SLOT * i] = 100.0 * equator;
+    volatile int interrupted = 0, failed = 0;
+
+    // Minimal distance to the nearest other point. Coincident points are each
+    // other's nearest neighbours at distances of 0, ordered by index. Failed
+    // searches of the tree are flagged in worker threads, and raised once all
+    // threads have finished.
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (dynamic, 1)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted || failed)
+            continue;
+        double *m = dmin + THREAD_SLOT * omp_get_thread_num ();
+        nn_match nn [2];
+        for (size_t k = blocks [b]; k < blocks [b + 1] && !failed; k++)
+        {
+            size_t i = idx [k];
+            size_t nk = nn_knn (t, rx [i], ry [i], 2, nn);
+            if (nk == NN_FAILED)
+            {
+                failed = 1; // # nocov
+                break; // # nocov
+            }
+            for (size_t l = 0; l < nk; l++)
+            {
+                if (nn [l].j == i)
+                    continue;
+                double d = bounds_dist (t, &p, simd, i, nn [l].j);
+                if ((p.u || simd) &&
+                        !bounds_nearest_rounded (t, &p, simd, i, &d))
+                {
+                    failed = 1; // # nocov
+                    break; // # nocov
+                }
+                if (d < *m)
+                    *m = d;
+            }
+        }
+    }
+    end_check_interrupt (interrupted);
+    if (failed)
+        Rf_error ("kd-tree search failed"); // # nocov
+
+    for (int i = 0; i < nthreads; i++)
+        if (dmin [THREAD_SLOT * i] < range [0])
+            range [0] = dmin [THREAD_SLOT * i];
+
+    // Lower bound on the maximum from the vertices of the hull:
+    size_t nh;
+    bounds_pt *hull = bounds_hull (pts, nf, &nh);
+    size_t *hidx = (size_t *) stats_alloc (nh, sizeof (size_t));
+    for (size_t h = 0; h < nh; h++)
+        hidx [h] = idx [hull [h].k];
+    double lower = bounds_max (t, &p, simd, hidx, nh, nthreads);
+
+    // Upper bound on the farthest distance from each point, which is less
+    // than the lower bound for all points which can not be an end of the
+    // farthest pair:
+    int *keep = (int *) stats_alloc (nf, sizeof (int));
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads (nthreads) schedule (static)
+#endif
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        master_check_interrupt (&interrupted);
+        if (interrupted)
+            continue;
+        for (size_t k = blocks [b]; k < blocks [b + 1]; k++)
+        {
+            keep [k] = 0;
+            for (size_t h = 0; h < nh && !keep [k]; h++)
+                keep [k] = bounds_upper (t, pos, k, hull [h].k) >= lower;
+        }
+    }
+    end_check_interrupt (interrupted);
+
+    size_t nc = 0;
+    for (size_t k = 0; k < nf; k++)
+        if (keep [k])
+            idx [nc++] = idx [k];
+
+    double upper = bounds_max (t, &p, simd, idx, nc, nthreads);
+    range [1] = (upper > lower) ? upper : lower;
+
+    UNPROTECT (3);
+
+    return out;
+}
+
+//' R_haversine_range_bounds
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_haversine_range_bounds (SEXP x_, SEXP threads_)
+{
+    return x_range_bounds (MEASURE_HAVERSINE, x_, threads_);
+}
+
+//' R_vincenty_range_bounds
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_vincenty_range_bounds (SEXP x_, SEXP threads_)
+{
+    return x_range_bounds (MEASURE_VINCENTY, x_, threads_);
+}
+
+//' R_cheap_range_bounds
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_cheap_range_bounds (SEXP x_, SEXP threads_)
+{
+    return x_range_bounds (MEASURE_CHEAP, x_, threads_);
+}
+
+//' R_geodesic_range_bounds
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_geodesic_range_bounds (SEXP x_, SEXP threads_)
+{
+    return x_range_bounds (MEASURE_GEODESIC, x_, threads_);
+}
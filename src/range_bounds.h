@@ -0,0 +1,20 @@
+#ifndef RANGE_BOUNDS_H
+#define RANGE_BOUNDS_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "WSG84-defs.h"
+#include "nearest.h"
+#include "threads.h"
+#include "kernels.h"
+
+SEXP R_haversine_range_bounds (SEXP x_, SEXP threads_);
+SEXP R_vincenty_range_bounds (SEXP x_, SEXP threads_);
+SEXP R_cheap_range_bounds (SEXP x_, SEXP threads_);
+SEXP R_geodesic_range_bounds (SEXP x_, SEXP threads_);
+
+#endif /* RANGE_BOUNDS_H */
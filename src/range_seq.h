@@ -6,10 +6,12 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "kernels.h"
 
 SEXP R_haversine_seq_range (SEXP x_);
 SEXP R_vincenty_seq_range (SEXP x_);
 SEXP R_cheap_seq_range (SEXP x_);
 SEXP R_geodesic_seq_range (SEXP x_);
+SEXP R_ruler_seq_range (SEXP x_);
 
 #endif /* RANGE_SEQ_H */
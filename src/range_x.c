@@ -1,189 +1,69 @@
 #include "range_x.h"
 
-//' R_haversine_range
-//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
-//' @noRd
-SEXP R_haversine_range (SEXP x_)
+static SEXP x_range (measure_t measure, SEXP x_, SEXP threads_)
 {
     size_t n = (size_t) (floor (length (x_) / 2));
-    double *rx;
-
-    double cosy1 [n]; // y-values are indexed in [n+1:n]
-    double min = 100.0 * equator, max = -100.0 * equator;
-    double d, *rout;
-    SEXP out;
+    int nthreads = get_num_threads (threads_);
 
     x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    rx = REAL (x_);
+    double *rx = REAL (x_);
 
-    for (size_t i = 0; i < n; i++)
-    {
-        cosy1 [i] = cos (rx [n + i] * M_PI / 180.0);
-    }
+    point_tables p;
+    point_tables_init (measure, rx, rx + n, n, &p);
 
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 100 == 0)
-            R_CheckUserInterrupt ();
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            d = one_haversine (rx [i], rx [n + i],
-                    rx [j], rx [n + j], cosy1 [i], cosy1 [j]);
-            if (d < min)
-                min = d;
-            if (d > max)
-                max = d;
-        }
-    }
+    double cosy = 0.0;
+    if (measure == MEASURE_CHEAP)
+        cosy = cheap_cosy (rx + n, n, NULL, 0);
 
-    out = PROTECT (allocVector (REALSXP, 2));
-    rout = REAL (out);
-    rout [0] = min;
-    rout [1] = max;
+    SEXP out = PROTECT (allocVector (REALSXP, 2));
+    kernel_tri_range (measure, &p, cosy, nthreads, REAL (out));
 
     UNPROTECT (2);
 
     return out;
 }
 
-//' R_vincenty_range
+//' R_haversine_range
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
 //' @noRd
-SEXP R_vincenty_range (SEXP x_)
+SEXP R_haversine_range (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    size_t n2 = n * n;
-    double *rx;
-
-    double siny1 [n], cosy1 [n]; // y-values are indexed in [n+1:n]
-    double min = 100.0 * equator, max = -100.0 * equator;
-    double d, *rout;
-    SEXP out;
-
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    rx = REAL (x_);
-
-    for (size_t i = 0; i < n; i++)
-    {
-        cosy1 [i] = cos (rx [n + i] * M_PI / 180.0);
-        siny1 [i] = sin (rx [n + i] * M_PI / 180.0);
-    }
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 100 == 0)
-            R_CheckUserInterrupt ();
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            d = one_vincenty (rx [i], rx [j],
-                    siny1 [i], cosy1 [i], siny1 [j], cosy1 [j]);
-            if (d < min)
-                min = d;
-            if (d > max)
-                max = d;
-        }
-    }
-
-    out = PROTECT (allocVector (REALSXP, n2));
-    rout = REAL (out);
-    rout [0] = min;
-    rout [1] = max;
-
-    UNPROTECT (2);
+    return x_range (MEASURE_HAVERSINE, x_, threads_);
+}
 
-    return out;
+//' R_vincenty_range
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_vincenty_range (SEXP x_, SEXP threads_)
+{
+    return x_range (MEASURE_VINCENTY, x_, threads_);
 }
 
 //' R_cheap_range
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
 //' @noRd
-SEXP R_cheap_range (SEXP x_)
+SEXP R_cheap_range (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    double *rx;
-
-    double ymin = 9999.9, ymax = -9999.9;
-    double min = 100.0 * equator, max = -100.0 * equator;
-    double cosy, d, *rout;
-    SEXP out;
-
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    rx = REAL (x_);
-
-    // Get maximal latitude range
-    for (size_t i = 0; i < n; i++)
-    {
-        if (rx [n + i] < ymin)
-            ymin = rx [n + i];
-        else if (rx [n + i] > ymax)
-            ymax = rx [n + i];
-    }
-    // and set constant cosine multiplier
-    ymin = ymin * M_PI / 180;
-    ymax = ymax * M_PI / 180;
-    cosy = cos ((ymin + ymax) / 2.0);
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 100 == 0)
-            R_CheckUserInterrupt ();
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            d = one_cheap (rx [i], rx [n + i],
-                    rx [j], rx [n + j], cosy);
-            if (d < min)
-                min = d;
-            if (d > max)
-                max = d;
-        }
-    }
-
-    out = PROTECT (allocVector (REALSXP, 2));
-    rout = REAL (out);
-    rout [0] = min;
-    rout [1] = max;
-
-    UNPROTECT (2);
-
-    return out;
+    return x_range (MEASURE_CHEAP, x_, threads_);
 }
 
 //' R_geodesic_range
 //' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
 //' @noRd
-SEXP R_geodesic_range (SEXP x_)
+SEXP R_geodesic_range (SEXP x_, SEXP threads_)
 {
-    size_t n = (size_t) (floor (length (x_) / 2));
-    double *rx;
-
-    double min = 100.0 * equator, max = -100.0 * equator;
-    double d, *rout;
-    SEXP out;
-
-    x_ = PROTECT (Rf_coerceVector (x_, REALSXP));
-    rx = REAL (x_);
-
-    for (size_t i = 0; i < (n - 1); i++)
-    {
-        if (i % 100 == 0)
-            R_CheckUserInterrupt ();
-        for (size_t j = (i + 1); j < n; j++)
-        {
-            d = one_geodesic (rx [i], rx [n + i],
-                    rx [j], rx [n + j]);
-            if (d < min)
-                min = d;
-            if (d > max)
-                max = d;
-        }
-    }
-
-    out = PROTECT (allocVector (REALSXP, 2));
-    rout = REAL (out);
-    rout [0] = min;
-    rout [1] = max;
-
-    UNPROTECT (2);
+    return x_range (MEASURE_GEODESIC, x_, threads_);
+}
 
-    return out;
+//' R_ruler_range
+//' @param x_ Single vector of x-values in [1:n], y-values in [n+(1:n)]
+//' @param threads_ Number of threads
+//' @noRd
+SEXP R_ruler_range (SEXP x_, SEXP threads_)
+{
+    return x_range (MEASURE_RULER, x_, threads_);
 }
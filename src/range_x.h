@@ -6,10 +6,12 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "kernels.h"
 
-SEXP R_haversine_range (SEXP x_);
-SEXP R_vincenty_range (SEXP x_);
-SEXP R_cheap_range (SEXP x_);
-SEXP R_geodesic_range (SEXP x_);
+SEXP R_haversine_range (SEXP x_, SEXP threads_);
+SEXP R_vincenty_range (SEXP x_, SEXP threads_);
+SEXP R_cheap_range (SEXP x_, SEXP threads_);
+SEXP R_geodesic_range (SEXP x_, SEXP threads_);
+SEXP R_ruler_range (SEXP x_, SEXP threads_);
 
 #endif /* RANGE_X_H */
@@ -6,10 +6,12 @@
 
 #include "common.h"
 #include "WSG84-defs.h"
+#include "kernels.h"
 
-SEXP R_haversine_xy_range (SEXP x_, SEXP y_);
-SEXP R_vincenty_xy_range (SEXP x_, SEXP y_);
-SEXP R_cheap_xy_range (SEXP x_, SEXP y_);
-SEXP R_geodesic_xy_range (SEXP x_, SEXP y_);
+SEXP R_haversine_xy_range (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_vincenty_xy_range (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_cheap_xy_range (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_geodesic_xy_range (SEXP x_, SEXP y_, SEXP threads_);
+SEXP R_ruler_xy_range (SEXP x_, SEXP y_, SEXP threads_);
 
 #endif /* RANGE_XY_H */
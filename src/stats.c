@@ -0,0 +1,298 @@
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+#include "threads.h"
+
+// Counters of pairs are held separately for each thread, each on its own cache
+// line. Threads beyond STATS_MAX_THREADS share the final slot atomically.
+#define STATS_MAX_THREADS 256
+#define STATS_MAX_ENTRIES 256
+
+typedef struct
+{
+    double n;
+    char pad [64 - sizeof (double)];
+} stats_counter;
+
+// Accumulated values for one .Call entry point
+typedef struct
+{
+    const char *name;
+    double calls, seconds, pairs, pruned, bytes;
+    int threads;
+} stats_entry;
+
+int stats_active = 0;
+int stats_on = 0;
+
+static stats_counter counters [STATS_MAX_THREADS];
+static stats_entry entries [STATS_MAX_ENTRIES];
+static size_t nentries = 0;
+
+// Values for the current call:
+static double call_start, call_bytes;
+static int call_threads, call_counting;
+
+static double wall_time (void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime ();
+#else
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+#endif
+}
+
+void stats_begin (void)
+{
+    memset (counters, 0, sizeof (counters));
+    call_bytes = 0.0;
+    call_threads = 1;
+    call_counting = 0;
+    stats_active = 1;
+    call_start = wall_time ();
+}
+
+void stats_add_count (double n)
+{
+    int tid = omp_get_thread_num ();
+    if (tid < STATS_MAX_THREADS - 1)
+        counters [tid].n += n;
+    else
+    {
+#ifdef _OPENMP
+        #pragma omp atomic
+#endif
+        counters [STATS_MAX_THREADS - 1].n += n;
+    }
+}
+
+//' Bytes allocated by the current call, which must be called from the master
+//' thread only, as are `stats_threads()` and `stats_counting()`.
+//' @noRd
+void stats_add_bytes (double bytes)
+{
+    if (stats_active)
+        call_bytes += bytes;
+}
+
+void stats_threads (int nthreads)
+{
+    if (stats_active && nthreads > call_threads)
+        call_threads = nthreads;
+}
+
+//' Declare that the current call prunes pairs, and counts those it evaluates
+//' with `stats_count()`
+//' @noRd
+void stats_counting (void)
+{
+    if (stats_active)
+        call_counting = 1;
+}
+
+//' R_alloc, with the number of bytes added to the current call
+//' @noRd
+void * stats_alloc (size_t n, int size)
+{
+    stats_add_bytes ((double) n * (double) size);
+    return (void *) R_alloc (n, size);
+}
+
+static double object_bytes (SEXP x)
+{
+    double bytes = 0.0;
+    R_xlen_t n = Rf_xlength (x);
+
+    switch (TYPEOF (x))
+    {
+        case REALSXP:
+            bytes = (double) n * sizeof (double);
+            break;
+        case INTSXP:
+        case LGLSXP:
+            bytes = (double) n * sizeof (int);
+            break;
+        case STRSXP:
+            bytes = (double) n * sizeof (SEXP);
+            break;
+        case VECSXP:
+            bytes = (double) n * sizeof (SEXP);
+            for (R_xlen_t i = 0; i < n; i++)
+                bytes += object_bytes (VECTOR_ELT (x, i));
+            break;
+        default:
+            break;
+    }
+
+    return bytes;
+}
+
+static stats_entry * find_entry (const char *name)
+{
+    for (size_t i = 0; i < nentries; i++)
+        if (strcmp (entries [i].name, name) == 0)
+            return entries + i;
+
+    if (nentries == STATS_MAX_ENTRIES)
+        return NULL;
+
+    stats_entry *e = entries + nentries++;
+    memset (e, 0, sizeof (stats_entry));
+    e->name = name;
+    return e;
+}
+
+//' Record one instrumented call
+//'
+//' @param name Name of the entry point, which must be a string literal.
+//' @param result Value returned by the entry point
+//' @param pairs Total number of pairs of points implied by the inputs, of
+//' which those not counted by kernels which prune pairs are recorded as pruned.
+//' @noRd
+void stats_end (const char *name, SEXP result, double pairs)
+{
+    double seconds = wall_time () - call_start;
+    stats_active = 0;
+
+    stats_entry *e = find_entry (name);
+    if (e == NULL)
+        return;
+
+    double evaluated = pairs;
+    if (call_counting)
+    {
+        evaluated = 0.0;
+        for (size_t i = 0; i < STATS_MAX_THREADS; i++)
+            evaluated += counters [i].n;
+        if (evaluated > pairs)
+            evaluated = pairs;
+    }
+
+    e->calls += 1.0;
+    e->seconds += seconds;
+    e->pairs += evaluated;
+    e->pruned += pairs - evaluated;
+    e->bytes += call_bytes + object_bytes (result);
+    if (call_threads > e->threads)
+        e->threads = call_threads;
+}
+
+// Numbers of pairs of points implied by the various shapes of inputs, with
+// matrix inputs holding x-values in [1:n], y-values in [n+(1:n)], and '_vec'
+// inputs holding one vector of each.
+
+double stats_pairs_x (SEXP x_)
+{
+    double n = floor ((double) Rf_xlength (x_) / 2.0);
+    return n * (n - 1.0) / 2.0;
+}
+
+//' @param y_ Second input, or NULL for all pairs within x_
+//' @noRd
+double stats_pairs_xy (SEXP x_, SEXP y_)
+{
+    if (Rf_isNull (y_))
+        return stats_pairs_x (x_);
+    return floor ((double) Rf_xlength (x_) / 2.0) *
+        floor ((double) Rf_xlength (y_) / 2.0);
+}
+
+double stats_pairs_seq (SEXP x_)
+{
+    double n = floor ((double) Rf_xlength (x_) / 2.0);
+    return (n > 0.0) ? n - 1.0 : 0.0;
+}
+
+double stats_pairs_paired (SEXP x_)
+{
+    return floor ((double) Rf_xlength (x_) / 2.0);
+}
+
+double stats_pairs_x_vec (SEXP x_)
+{
+    double n = (double) Rf_xlength (x_);
+    return n * (n - 1.0) / 2.0;
+}
+
+double stats_pairs_seq_vec (SEXP x_)
+{
+    double n = (double) Rf_xlength (x_);
+    return (n > 0.0) ? n - 1.0 : 0.0;
+}
+
+double stats_pairs_paired_vec (SEXP x_)
+{
+    return (double) Rf_xlength (x_);
+}
+
+double stats_pairs_xy_vec (SEXP x1_, SEXP x2_)
+{
+    return (double) Rf_xlength (x1_) * (double) Rf_xlength (x2_);
+}
+
+//' @param starts_ Offsets of groups followed by the total number of points,
+//' as for `R_haversine_seq_groups`
+//' @noRd
+double stats_pairs_groups (SEXP x_, SEXP y_, SEXP starts_)
+{
+    double n = (double) Rf_xlength (x_);
+    if (Rf_isNull (y_))
+        n = floor (n / 2.0);
+    double ngroups = (double) Rf_xlength (starts_) - 1.0;
+    return (n > ngroups) ? n - ngroups : 0.0;
+}
+
+//' R_stats
+//'
+//' Accumulated statistics of all instrumented calls.
+//' @param reset_ If TRUE, clear all statistics after returning them.
+//' @param enable_ If TRUE or FALSE, switch instrumentation of all subsequent
+//' calls on or off; if NULL, leave it unchanged. Switching also clears any
+//' 'stats_active' flag left by an instrumented call which ended in an error.
+//' @return List of vectors of entry names, numbers of calls, total seconds,
+//' pairs evaluated, pairs pruned, maximal threads, and bytes allocated.
+//' @noRd
+SEXP R_stats (SEXP reset_, SEXP enable_)
+{
+    const char *nms [] = {"entry", "calls", "seconds", "pairs", "pruned",
+        "threads", "bytes"};
+    const int ncols = 7;
+    int n = (int) nentries;
+
+    SEXP out = PROTECT (allocVector (VECSXP, ncols));
+    SEXP names = PROTECT (allocVector (STRSXP, ncols));
+    SET_VECTOR_ELT (out, 0, allocVector (STRSXP, n));
+    for (int k = 1; k < ncols; k++)
+        SET_VECTOR_ELT (out, k,
+                allocVector ((k == 5) ? INTSXP : REALSXP, n));
+    for (int k = 0; k < ncols; k++)
+        SET_STRING_ELT (names, k, mkChar (nms [k]));
+    setAttrib (out, R_NamesSymbol, names);
+
+    for (int i = 0; i < n; i++)
+    {
+        SET_STRING_ELT (VECTOR_ELT (out, 0), i, mkChar (entries [i].name));
+        REAL (VECTOR_ELT (out, 1)) [i] = entries [i].calls;
+        REAL (VECTOR_ELT (out, 2)) [i] = entries [i].seconds;
+        REAL (VECTOR_ELT (out, 3)) [i] = entries [i].pairs;
+        REAL (VECTOR_ELT (out, 4)) [i] = entries [i].pruned;
+        INTEGER (VECTOR_ELT (out, 5)) [i] = entries [i].threads;
+        REAL (VECTOR_ELT (out, 6)) [i] = entries [i].bytes;
+    }
+
+    if (asLogical (reset_) == 1)
+        nentries = 0;
+    if (!Rf_isNull (enable_))
+    {
+        stats_on = asLogical (enable_) == 1;
+        stats_active = 0;
+    }
+
+    UNPROTECT (2);
+
+    return out;
+}
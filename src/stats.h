@@ -0,0 +1,53 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stddef.h>
+
+// Opt-in instrumentation of .Call entry points, enabled with
+// 'geodist_stats (enable = TRUE)'. Each registered entry is wrapped in
+// geodist_init.c to record times, numbers of pairs of points, threads, and
+// bytes allocated. 'stats_on' is only changed by `R_stats()`, so that
+// uninstrumented calls cost a single check of that flag, and 'stats_active'
+// is only set for the duration of an instrumented call, so that counters
+// cost a single branch otherwise.
+extern int stats_active;
+extern int stats_on;
+
+void stats_begin (void);
+void stats_end (const char *name, SEXP result, double pairs);
+
+void stats_add_count (double n);
+void stats_add_bytes (double bytes);
+void stats_threads (int nthreads);
+void stats_counting (void);
+
+void * stats_alloc (size_t n, int size);
+
+double stats_pairs_x (SEXP x_);
+double stats_pairs_xy (SEXP x_, SEXP y_);
+double stats_pairs_seq (SEXP x_);
+double stats_pairs_paired (SEXP x_);
+double stats_pairs_x_vec (SEXP x_);
+double stats_pairs_seq_vec (SEXP x_);
+double stats_pairs_paired_vec (SEXP x_);
+double stats_pairs_xy_vec (SEXP x1_, SEXP x2_);
+double stats_pairs_groups (SEXP x_, SEXP y_, SEXP starts_);
+
+//' Add n pairs evaluated by the calling thread
+//'
+//' Kernels which prune pairs call `stats_counting()` from the master thread
+//' before any calls to this function. Counts are accumulated separately for
+//' each thread, and summed at the end of the call.
+//' @noRd
+static inline void stats_count (double n)
+{
+    if (stats_active)
+        stats_add_count (n);
+}
+
+SEXP R_stats (SEXP reset_, SEXP enable_);
+
+#endif /* STATS_H */
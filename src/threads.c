@@ -0,0 +1,136 @@
+#include <stdint.h>
+
+#include "threads.h"
+
+// Rows are processed in blocks distributed dynamically across threads. There
+// are at least 8 blocks per thread for load balancing, and no block has more
+// than 1000 rows, so the master thread checks for interrupts at least as
+// often as the original serial loops.
+#define BLOCKS_PER_THREAD 8
+#define MAX_BLOCK_ROWS 1000
+
+//' Number of threads requested from R
+//'
+//' @param threads_ Single integer value; values < 1 or NA are treated as 1.
+//' Without OpenMP support, always 1.
+//' @noRd
+int get_num_threads (SEXP threads_)
+{
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = Rf_asInteger (threads_);
+    if (nthreads == NA_INTEGER || nthreads < 1)
+        nthreads = 1;
+#endif
+    stats_threads (nthreads);
+    return nthreads;
+}
+
+//' Accumulators of each thread, each on its own cache line
+//'
+//' @return R_alloc-ed array aligned to 64 bytes, of which thread t may use
+//' the THREAD_SLOT values from t * THREAD_SLOT.
+//' @noRd
+double * thread_slots (int nthreads)
+{
+    double *p = (double *) stats_alloc ((size_t) (nthreads + 1) * THREAD_SLOT,
+            sizeof (double));
+    size_t offset = (size_t) ((uintptr_t) p % (THREAD_SLOT * sizeof (double)));
+    if (offset > 0)
+        p += THREAD_SLOT - offset / sizeof (double);
+    return p;
+}
+
+static size_t num_blocks (size_t n, int nthreads)
+{
+    size_t nblocks = (size_t) nthreads * BLOCKS_PER_THREAD;
+    if (nblocks < (n + MAX_BLOCK_ROWS - 1) / MAX_BLOCK_ROWS)
+        nblocks = (n + MAX_BLOCK_ROWS - 1) / MAX_BLOCK_ROWS;
+    if (nblocks > n)
+        nblocks = n;
+    return nblocks;
+}
+
+//' Partition n rows of equal work into contiguous blocks
+//'
+//' @return R_alloc-ed array of (nblocks + 1) row indices, so that block b
+//' spans [starts[b], starts[b + 1]).
+//' @noRd
+size_t * row_blocks (size_t n, int nthreads, size_t *nblocks)
+{
+    size_t nb = num_blocks (n, nthreads);
+    size_t *starts = (size_t *) stats_alloc (nb + 1, sizeof (size_t));
+
+    for (size_t b = 0; b <= nb; b++)
+        starts [b] = (nb == 0) ? 0 : (b * n) / nb;
+
+    *nblocks = nb;
+    return starts;
+}
+
+//' Partition the rows of an upper triangle into blocks of equal work
+//'
+//' Row i of an n-by-n upper triangle has (n - 1 - i) pairs, so equally-sized
+//' blocks of rows would leave the threads handling the final blocks with
+//' almost nothing to do. Blocks are instead closed once they hold
+//' (total / nblocks) pairs, or MAX_BLOCK_ROWS rows.
+//'
+//' @return R_alloc-ed array of (nblocks + 1) row indices over the (n - 1) rows
+//' of the upper triangle.
+//' @noRd
+size_t * tri_row_blocks (size_t n, int nthreads, size_t *nblocks)
+{
+    size_t nrows = (n > 1) ? n - 1 : 0;
+    size_t nb_target = num_blocks (nrows, nthreads);
+    if (nb_target == 0)
+        nb_target = 1;
+    size_t nb_max = nb_target + nrows / MAX_BLOCK_ROWS + 2;
+    size_t *starts = (size_t *) stats_alloc (nb_max, sizeof (size_t));
+
+    double target = (double) n * (double) nrows / 2.0 / (double) nb_target;
+    double npairs = 0.0;
+    size_t nb = 0;
+
+    starts [0] = 0;
+    for (size_t i = 0; i < nrows; i++)
+    {
+        npairs += (double) (n - 1 - i);
+        if (npairs >= target || (i + 1 - starts [nb]) >= MAX_BLOCK_ROWS)
+        {
+            starts [++nb] = i + 1;
+            npairs = 0.0;
+        }
+    }
+    if (starts [nb] < nrows)
+        starts [++nb] = nrows;
+
+    *nblocks = nb;
+    return starts;
+}
+
+static void check_interrupt_fn (void *dummy)
+{
+    R_CheckUserInterrupt ();
+}
+
+//' Check for user interrupts from the master thread only
+//'
+//' R_CheckUserInterrupt longjmps on interrupt, which must never happen inside
+//' a parallel region, so it is wrapped in R_ToplevelExec, and the interrupt
+//' only flagged here. All threads then skip any remaining blocks, and
+//' `end_check_interrupt()` raises the error once the region has finished.
+//' @noRd
+void master_check_interrupt (volatile int *interrupted)
+{
+    if (omp_get_thread_num () == 0 && !*interrupted)
+    {
+        if (R_ToplevelExec (check_interrupt_fn, NULL) == FALSE)
+            *interrupted = 1; // # nocov
+    }
+}
+
+void end_check_interrupt (int interrupted)
+{
+    if (interrupted)
+        Rf_error ("Calculation interrupted by user"); // # nocov
+}
@@ -0,0 +1,28 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "stats.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#endif
+
+// Number of doubles in one cache line of 64 bytes, by which the accumulators
+// of each thread are spaced, so that no two threads write to the same line.
+#define THREAD_SLOT 8
+
+int get_num_threads (SEXP threads_);
+double * thread_slots (int nthreads);
+
+size_t * row_blocks (size_t n, int nthreads, size_t *nblocks);
+size_t * tri_row_blocks (size_t n, int nthreads, size_t *nblocks);
+
+void master_check_interrupt (volatile int *interrupted);
+void end_check_interrupt (int interrupted);
+
+#endif /* THREADS_H */
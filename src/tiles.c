@@ -0,0 +1,12 @@
+#include "tiles.h"
+
+//' Scratch space of 4 * TILE_NY values for each thread
+//'
+//' Allocated with R_alloc, and so must be called outside parallel regions.
+//' The space of each thread starts at (omp_get_thread_num () * 4 * TILE_NY).
+//' @noRd
+double * tile_scratch (int nthreads)
+{
+    return (double *) stats_alloc ((size_t) nthreads * 4 * TILE_NY,
+            sizeof (double));
+}
@@ -0,0 +1,18 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include <stddef.h>
+
+#include "threads.h"
+
+// Number of points of y in each tile. Longitudes, latitudes, and sines and
+// cosines of latitudes of one tile then occupy 32KB, so remain in L1 or L2
+// cache while every row of x in a block is compared against them.
+#define TILE_NY 1024
+
+double * tile_scratch (int nthreads);
+
+#endif /* TILES_H */